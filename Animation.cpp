@@ -0,0 +1,186 @@
+#include "Animation.h"
+#include <iostream>
+
+int AnimationStateMachine::addState(int clip) {
+    stateClips.push_back(clip);
+    transitions.emplace_back();
+    return static_cast<int>(stateClips.size()) - 1;
+}
+
+void AnimationStateMachine::addTransition(int fromState, int toState, int trigger) {
+    transitions[fromState].push_back({ toState, trigger });
+}
+
+AnimationSystem::AnimationSystem(const SpriteAtlas& atlas) : atlas(atlas) {
+}
+
+int AnimationSystem::addClip(const std::string& name, const std::vector<AnimationFrame>& clipFrames, LoopMode loop) {
+    if (clipFrames.empty()) {
+        std::cerr << "Animation clip " << name << " has no frames" << std::endl;
+        return -1;
+    }
+    clipNames.push_back(name);
+    clipFirstFrame.push_back(static_cast<int>(frameRegions.size()));
+    clipFrameCount.push_back(static_cast<int>(clipFrames.size()));
+    clipLoop.push_back(loop);
+    for (const AnimationFrame& frame : clipFrames) {
+        frameRegions.push_back(frame.region);
+        frameDurations.push_back(frame.duration > 0.001f ? frame.duration : 0.001f);  // Zero would never advance time
+    }
+    return static_cast<int>(clipNames.size()) - 1;
+}
+
+int AnimationSystem::findClip(const std::string& name) const {
+    for (size_t i = 0; i < clipNames.size(); ++i) {
+        if (clipNames[i] == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+int AnimationSystem::addStateMachine(const AnimationStateMachine& machine) {
+    int firstState = static_cast<int>(stateClips.size());
+    machineFirstState.push_back(firstState);
+    for (size_t state = 0; state < machine.stateClips.size(); ++state) {
+        stateClips.push_back(machine.stateClips[state]);
+        stateFirstTransition.push_back(static_cast<int>(transitionTargets.size()));
+        stateTransitionCount.push_back(static_cast<int>(machine.transitions[state].size()));
+        for (const AnimationStateMachine::Transition& transition : machine.transitions[state]) {
+            transitionTargets.push_back(firstState + transition.toState);
+            transitionTriggers.push_back(transition.trigger);
+        }
+    }
+    return static_cast<int>(machineFirstState.size()) - 1;
+}
+
+int AnimationSystem::allocateSlot() {
+    if (!freeSlots.empty()) {
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+    clips.push_back(-1);
+    frames.push_back(0);
+    times.push_back(0.0f);
+    speeds.push_back(1.0f);
+    directions.push_back(1);
+    finished.push_back(0);
+    machines.push_back(-1);
+    states.push_back(-1);
+    triggers.push_back(0);
+    regions.push_back(0);
+    return static_cast<int>(clips.size()) - 1;
+}
+
+void AnimationSystem::resetAnimator(int animator, int clip) {
+    clips[animator] = clip;
+    frames[animator] = 0;
+    times[animator] = 0.0f;
+    directions[animator] = 1;
+    finished[animator] = 0;
+    regions[animator] = frameRegions[clipFirstFrame[clip]];
+}
+
+int AnimationSystem::createAnimator(int clip, float speed) {
+    int animator = allocateSlot();
+    resetAnimator(animator, clip);
+    speeds[animator] = speed;
+    machines[animator] = -1;
+    states[animator] = -1;
+    triggers[animator] = 0;
+    return animator;
+}
+
+int AnimationSystem::createStateMachineAnimator(int machine, int startState) {
+    int state = machineFirstState[machine] + startState;
+    int animator = createAnimator(stateClips[state]);
+    machines[animator] = machine;
+    states[animator] = state;
+    return animator;
+}
+
+void AnimationSystem::removeAnimator(int animator) {
+    clips[animator] = -1;
+    machines[animator] = -1;
+    states[animator] = -1;
+    freeSlots.push_back(animator);
+}
+
+void AnimationSystem::play(int animator, int clip) {
+    resetAnimator(animator, clip);
+}
+
+void AnimationSystem::setTrigger(int animator, int trigger) {
+    triggers[animator] |= 1u << trigger;
+}
+
+int AnimationSystem::getState(int animator) const {
+    if (machines[animator] < 0) return -1;
+    return states[animator] - machineFirstState[machines[animator]];
+}
+
+void AnimationSystem::update(float deltaTime) {
+    finishedLastUpdate.clear();
+    const int count = static_cast<int>(clips.size());
+    for (int i = 0; i < count; ++i) {
+        int clip = clips[i];
+        if (clip < 0) continue;  // Free slot
+
+        // Advance through as many frames as the elapsed time covers
+        const int first = clipFirstFrame[clip];
+        const int frameCount = clipFrameCount[clip];
+        int frame = frames[i];
+        float time = times[i] + deltaTime * speeds[i];
+        while (!finished[i] && time >= frameDurations[first + frame]) {
+            time -= frameDurations[first + frame];
+            int next = frame + directions[i];
+            if (next >= 0 && next < frameCount) {
+                frame = next;
+                continue;
+            }
+            switch (clipLoop[clip]) {
+            case LoopMode::Once:
+                finished[i] = 1;
+                finishedLastUpdate.push_back(i);
+                time = 0.0f;
+                break;
+            case LoopMode::Loop:
+                frame = 0;
+                break;
+            case LoopMode::PingPong:
+                directions[i] = static_cast<int8_t>(-directions[i]);
+                frame = frameCount > 1 ? frame + directions[i] : frame;
+                break;
+            }
+            if (frameCount == 1 && clipLoop[clip] != LoopMode::Once) {
+                time = 0.0f;  // A single looping frame never changes
+                break;
+            }
+        }
+
+        // State machine transitions: the first matching transition wins
+        int state = states[i];
+        if (state >= 0) {
+            const int firstTransition = stateFirstTransition[state];
+            const int transitionCount = stateTransitionCount[state];
+            for (int t = firstTransition; t < firstTransition + transitionCount; ++t) {
+                int trigger = transitionTriggers[t];
+                bool fire = trigger < 0 ? finished[i] != 0 : (triggers[i] & (1u << trigger)) != 0;
+                if (fire) {
+                    states[i] = transitionTargets[t];
+                    clip = stateClips[states[i]];
+                    clips[i] = clip;
+                    frame = 0;
+                    time = 0.0f;
+                    directions[i] = 1;
+                    finished[i] = 0;
+                    break;
+                }
+            }
+            triggers[i] = 0;  // Triggers only count for the frame they were raised in
+        }
+
+        frames[i] = frame;
+        times[i] = time;
+        regions[i] = frameRegions[clipFirstFrame[clip] + frame];
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <SDL.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Atlas.h"
+
+// How a clip behaves when it reaches its last frame
+enum class LoopMode : uint8_t {
+    Once,     // Stop on the last frame
+    Loop,     // Jump back to the first frame
+    PingPong  // Play backwards, then forwards again
+};
+
+// One frame of a clip: which atlas region to show and for how long
+struct AnimationFrame {
+    int region;      // Index into SpriteAtlas::regions
+    float duration;  // Seconds
+};
+
+// Animation state machine shared by many animators.
+// States play a clip; transitions fire on a trigger or when a non-looping clip finishes.
+struct AnimationStateMachine {
+    struct Transition {
+        int toState;
+        int trigger;  // Trigger bit (0-31), or -1 to fire when the clip finishes
+    };
+
+    std::vector<int> stateClips;                      // Clip played by each state
+    std::vector<std::vector<Transition>> transitions;  // Outgoing transitions per state
+
+    int addState(int clip);
+    void addTransition(int fromState, int toState, int trigger);
+};
+
+// Plays sprite-sheet animations for every animated entity of one atlas.
+// Animator state is stored as parallel arrays so update() is a single linear pass
+// that only writes the atlas region each animator should show.
+class AnimationSystem {
+public:
+    explicit AnimationSystem(const SpriteAtlas& atlas);
+
+    // Clips and state machines are defined once and shared by all animators.
+    // A clip needs at least one frame; addClip() returns -1 for an empty one.
+    int addClip(const std::string& name, const std::vector<AnimationFrame>& frames, LoopMode loop);
+    int findClip(const std::string& name) const;
+    int addStateMachine(const AnimationStateMachine& machine);
+
+    // Animators are handles into the arrays below; removed slots are reused
+    int createAnimator(int clip, float speed = 1.0f);
+    int createStateMachineAnimator(int machine, int startState = 0);
+    void removeAnimator(int animator);
+
+    void play(int animator, int clip);             // Restart an animator on another clip
+    void setTrigger(int animator, int trigger);    // Raise a trigger for the animator's state machine
+    void setSpeed(int animator, float speed) { speeds[animator] = speed; }
+    bool isFinished(int animator) const { return finished[animator] != 0; }
+    int getState(int animator) const;              // State within the animator's state machine, or -1
+
+    void update(float deltaTime);  // Advance every animator
+    // Animators whose clip reached its end in the last update(), for whoever waits on them
+    const std::vector<int>& getFinishedLastUpdate() const { return finishedLastUpdate; }
+
+    int getRegion(int animator) const { return regions[animator]; }
+    const SDL_Rect& getSourceRect(int animator) const { return atlas.regions[regions[animator]]; }
+    SDL_Texture* getTexture() const { return atlas.texture; }
+    int getAnimatorCount() const { return static_cast<int>(clips.size() - freeSlots.size()); }
+
+private:
+    const SpriteAtlas& atlas;
+
+    // Clip data, flattened so all frames live in one array
+    std::vector<std::string> clipNames;
+    std::vector<int> clipFirstFrame;
+    std::vector<int> clipFrameCount;
+    std::vector<LoopMode> clipLoop;
+    std::vector<int> frameRegions;
+    std::vector<float> frameDurations;
+
+    // State machines, flattened: each state owns a contiguous transition range
+    std::vector<int> machineFirstState;
+    std::vector<int> stateClips;
+    std::vector<int> stateFirstTransition;
+    std::vector<int> stateTransitionCount;
+    std::vector<int> transitionTargets;  // Global state index
+    std::vector<int> transitionTriggers;
+
+    // Per-animator arrays (structure of arrays)
+    std::vector<int> clips;          // -1 for a free slot
+    std::vector<int> frames;         // Frame index within the clip
+    std::vector<float> times;        // Time spent on the current frame
+    std::vector<float> speeds;       // Playback rate multiplier
+    std::vector<int8_t> directions;  // +1 forwards, -1 backwards (ping-pong)
+    std::vector<uint8_t> finished;   // Non-looping clip reached its end
+    std::vector<int> machines;       // State machine, or -1 for a plain clip
+    std::vector<int> states;         // Global state index, or -1 without a state machine
+    std::vector<uint32_t> triggers;  // Pending trigger bits
+    std::vector<int> regions;        // Output: atlas region to draw
+    std::vector<int> freeSlots;
+    std::vector<int> finishedLastUpdate;
+
+    int allocateSlot();
+    void resetAnimator(int animator, int clip);
+};
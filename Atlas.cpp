@@ -0,0 +1,184 @@
+#include "Atlas.h"
+#include <algorithm>
+#include <iostream>
+
+SpriteAtlas createGridAtlas(SDL_Texture* texture, int frameWidth, int frameHeight) {
+    SpriteAtlas atlas;
+    atlas.texture = texture;
+    SDL_QueryTexture(texture, nullptr, nullptr, &atlas.width, &atlas.height);
+    if (frameWidth <= 0 || frameHeight <= 0) return atlas;
+
+    // Only whole frames are used, leftover pixels at the edges are ignored
+    for (int y = 0; y + frameHeight <= atlas.height; y += frameHeight) {
+        for (int x = 0; x + frameWidth <= atlas.width; x += frameWidth) {
+            atlas.regions.push_back({ x, y, frameWidth, frameHeight });
+        }
+    }
+    return atlas;
+}
+
+int addAtlasRegion(SpriteAtlas& atlas, const SDL_Rect& region) {
+    atlas.regions.push_back(region);
+    return static_cast<int>(atlas.regions.size()) - 1;
+}
+
+// RGBA image used while building atlas levels
+struct AtlasImage {
+    int width = 0, height = 0;
+    std::vector<Uint8> pixels;  // RGBA, 4 bytes per pixel
+};
+
+static bool toAtlasImage(SDL_Surface* surface, AtlasImage& image) {
+    if (!surface) return false;
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!rgba) return false;
+    image.width = rgba->w;
+    image.height = rgba->h;
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+    for (int y = 0; y < image.height; ++y) {
+        const Uint8* row = static_cast<const Uint8*>(rgba->pixels) + y * rgba->pitch;
+        std::copy(row, row + image.width * 4, &image.pixels[static_cast<size_t>(y) * image.width * 4]);
+    }
+    SDL_FreeSurface(rgba);
+    return true;
+}
+
+// Halves an image with a 2x2 box filter. Colours are weighted by alpha so
+// transparent pixels do not darken the edges of the sprite.
+static AtlasImage downsample(const AtlasImage& source) {
+    AtlasImage result;
+    result.width = std::max(1, source.width / 2);
+    result.height = std::max(1, source.height / 2);
+    result.pixels.resize(static_cast<size_t>(result.width) * result.height * 4);
+    for (int y = 0; y < result.height; ++y) {
+        for (int x = 0; x < result.width; ++x) {
+            int sum[4] = {};
+            for (int dy = 0; dy < 2; ++dy) {
+                for (int dx = 0; dx < 2; ++dx) {
+                    int sx = std::min(x * 2 + dx, source.width - 1);
+                    int sy = std::min(y * 2 + dy, source.height - 1);
+                    const Uint8* p = &source.pixels[(static_cast<size_t>(sy) * source.width + sx) * 4];
+                    sum[0] += p[0] * p[3];
+                    sum[1] += p[1] * p[3];
+                    sum[2] += p[2] * p[3];
+                    sum[3] += p[3];
+                }
+            }
+            Uint8* out = &result.pixels[(static_cast<size_t>(y) * result.width + x) * 4];
+            for (int c = 0; c < 3; ++c) {
+                out[c] = static_cast<Uint8>(sum[3] ? sum[c] / sum[3] : 0);
+            }
+            out[3] = static_cast<Uint8>(sum[3] / 4);
+        }
+    }
+    return result;
+}
+
+// Packs images on shelves into one texture. Each image is surrounded by a gutter
+// filled with its own edge pixels, so filtering never samples a neighbour.
+static SDL_Texture* packImages(SDL_Renderer* renderer, const std::vector<AtlasImage>& images, int padding,
+                               std::vector<SDL_Rect>& regions, int& atlasWidth, int& atlasHeight) {
+    int widest = 0;
+    int totalArea = 0;
+    for (const AtlasImage& image : images) {
+        widest = std::max(widest, image.width + padding * 2);
+        totalArea += (image.width + padding * 2) * (image.height + padding * 2);
+    }
+    atlasWidth = 16;
+    while (atlasWidth < widest || atlasWidth * atlasWidth < totalArea) atlasWidth *= 2;
+
+    // Place images left to right, starting a new shelf when a row is full
+    regions.clear();
+    int x = 0, y = 0, shelfHeight = 0;
+    for (const AtlasImage& image : images) {
+        int w = image.width + padding * 2, h = image.height + padding * 2;
+        if (x + w > atlasWidth) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        regions.push_back({ x + padding, y + padding, image.width, image.height });
+        x += w;
+        shelfHeight = std::max(shelfHeight, h);
+    }
+    atlasHeight = y + shelfHeight;
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) return nullptr;
+    SDL_memset(surface->pixels, 0, static_cast<size_t>(surface->pitch) * atlasHeight);
+
+    for (size_t i = 0; i < images.size(); ++i) {
+        const AtlasImage& image = images[i];
+        const SDL_Rect& region = regions[i];
+        for (int py = -padding; py < image.height + padding; ++py) {
+            int sy = std::min(std::max(py, 0), image.height - 1);
+            Uint8* row = static_cast<Uint8*>(surface->pixels) + (region.y + py) * surface->pitch;
+            for (int px = -padding; px < image.width + padding; ++px) {
+                int sx = std::min(std::max(px, 0), image.width - 1);
+                const Uint8* p = &image.pixels[(static_cast<size_t>(sy) * image.width + sx) * 4];
+                std::copy(p, p + 4, row + (region.x + px) * 4);
+            }
+        }
+    }
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_FreeSurface(surface);
+    if (texture) SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return texture;
+}
+
+bool buildAtlas(SDL_Renderer* renderer, const std::vector<SDL_Surface*>& images, int mipLevelCount, int padding,
+                SpriteAtlas& atlas) {
+    std::vector<AtlasImage> level(images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (!toAtlasImage(images[i], level[i])) {
+            std::cerr << "Failed to add image " << i << " to atlas: " << SDL_GetError() << std::endl;
+            return false;
+        }
+    }
+
+    atlas.texture = packImages(renderer, level, padding, atlas.regions, atlas.width, atlas.height);
+    if (!atlas.texture) {
+        std::cerr << "Failed to create atlas texture: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    // Each level is built from the previous one, one image at a time, so regions never mix
+    atlas.mipLevels.clear();
+    for (int mip = 1; mip <= mipLevelCount; ++mip) {
+        bool canShrink = false;
+        for (AtlasImage& image : level) {
+            canShrink = canShrink || image.width > 1 || image.height > 1;
+            image = downsample(image);
+        }
+        if (!canShrink) break;
+
+        AtlasLevel mipLevel;
+        int width, height;
+        mipLevel.texture = packImages(renderer, level, padding, mipLevel.regions, width, height);
+        if (!mipLevel.texture) break;  // Missing levels only cost quality
+        SDL_SetTextureScaleMode(mipLevel.texture, SDL_ScaleModeLinear);
+        atlas.mipLevels.push_back(std::move(mipLevel));
+    }
+    return true;
+}
+
+int selectAtlasLevel(const SpriteAtlas& atlas, float pixelsPerTexel) {
+    // Every halving of on-screen size moves one level down
+    int level = 0;
+    while (level < static_cast<int>(atlas.mipLevels.size()) && pixelsPerTexel < 0.75f) {
+        pixelsPerTexel *= 2.0f;
+        ++level;
+    }
+    return level;
+}
+
+SDL_Texture* getAtlasRegion(const SpriteAtlas& atlas, int level, int region, const SDL_Rect*& source) {
+    if (level == 0) {
+        source = &atlas.regions[region];
+        return atlas.texture;
+    }
+    const AtlasLevel& mipLevel = atlas.mipLevels[level - 1];
+    source = &mipLevel.regions[region];
+    return mipLevel.texture;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+
+// A downsampled copy of an atlas: level 1 is half size, level 2 a quarter, and so on
+struct AtlasLevel {
+    SDL_Texture* texture = nullptr;
+    std::vector<SDL_Rect> regions;  // Same region indices as the full-size atlas
+};
+
+// A texture holding many sprite images, addressed by region index
+struct SpriteAtlas {
+    SDL_Texture* texture = nullptr;  // Atlas texture (owned by whoever loaded it)
+    int width = 0, height = 0;       // Texture size in pixels
+    std::vector<SDL_Rect> regions;   // Source rectangles of the individual images
+    std::vector<AtlasLevel> mipLevels;  // Downsampled levels 1..n, empty if none were built
+};
+
+// Creates an atlas over a sprite sheet by slicing it into equally sized frames, row by row
+SpriteAtlas createGridAtlas(SDL_Texture* texture, int frameWidth, int frameHeight);
+
+// Adds a region to the atlas and returns its index
+int addAtlasRegion(SpriteAtlas& atlas, const SDL_Rect& region);
+
+// Packs images into a new atlas texture, leaving a padding gutter around each image so
+// neighbours never bleed into each other, and builds up to mipLevelCount downsampled levels.
+// Region i is images[i]. The atlas owns no surfaces; its textures are created on the renderer.
+bool buildAtlas(SDL_Renderer* renderer, const std::vector<SDL_Surface*>& images, int mipLevelCount, int padding,
+                SpriteAtlas& atlas);
+
+// Picks the mip level to draw with when one full-size texel covers pixelsPerTexel screen pixels
+// (camera zoom times sprite magnification). Level 0 is the full-size atlas.
+int selectAtlasLevel(const SpriteAtlas& atlas, float pixelsPerTexel);
+
+// Texture and source rectangle of a region at a mip level
+SDL_Texture* getAtlasRegion(const SpriteAtlas& atlas, int level, int region, const SDL_Rect*& source);
@@ -0,0 +1,379 @@
+#include "Broadphase.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+Broadphase::Broadphase(int cellSize, int bucketCount) : cellSize(cellSize), buckets(bucketCount) {
+}
+
+size_t Broadphase::bucketIndex(int cellX, int cellY) const {
+    unsigned hash = static_cast<unsigned>(cellX) * 73856093u ^ static_cast<unsigned>(cellY) * 19349663u;
+    return hash % buckets.size();
+}
+
+int Broadphase::toCell(int coordinate) const {
+    // Round towards negative infinity so negative positions get their own cells
+    return coordinate >= 0 ? coordinate / cellSize : (coordinate - cellSize + 1) / cellSize;
+}
+
+void Broadphase::insertCells(int proxy) {
+    Proxy& p = proxies[proxy];
+    p.minCellX = toCell(p.rect.x);
+    p.minCellY = toCell(p.rect.y);
+    p.maxCellX = toCell(p.rect.x + std::max(p.rect.w, 1) - 1);
+    p.maxCellY = toCell(p.rect.y + std::max(p.rect.h, 1) - 1);
+    for (int y = p.minCellY; y <= p.maxCellY; ++y) {
+        for (int x = p.minCellX; x <= p.maxCellX; ++x) {
+            buckets[bucketIndex(x, y)].push_back({ x, y, proxy, p.layer, p.mask });
+        }
+    }
+}
+
+void Broadphase::removeCells(int proxy) {
+    const Proxy& p = proxies[proxy];
+    for (int y = p.minCellY; y <= p.maxCellY; ++y) {
+        for (int x = p.minCellX; x <= p.maxCellX; ++x) {
+            std::vector<CellEntry>& bucket = buckets[bucketIndex(x, y)];
+            for (size_t i = 0; i < bucket.size(); ++i) {
+                if (bucket[i].proxy == proxy && bucket[i].cellX == x && bucket[i].cellY == y) {
+                    bucket[i] = bucket.back();  // Order inside a bucket does not matter
+                    bucket.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int Broadphase::createProxy(const SDL_Rect& rect, int userData, int flags, uint32_t layer, uint32_t mask) {
+    int proxy;
+    if (!freeProxies.empty()) {
+        proxy = freeProxies.back();
+        freeProxies.pop_back();
+    }
+    else {
+        proxy = static_cast<int>(proxies.size());
+        proxies.emplace_back();
+    }
+
+    Proxy& p = proxies[proxy];
+    p.rect = rect;
+    p.userData = userData;
+    p.flags = flags;
+    p.layer = layer;
+    p.mask = mask;
+    p.sleeping = false;
+    p.alive = true;
+    p.movingIndex = -1;
+    if (!(flags & PROXY_STATIC)) {
+        p.movingIndex = static_cast<int>(movingProxies.size());
+        movingProxies.push_back(proxy);
+    }
+    insertCells(proxy);
+    return proxy;
+}
+
+void Broadphase::destroyProxy(int proxy) {
+    removeCells(proxy);
+    Proxy& p = proxies[proxy];
+    if (p.movingIndex >= 0) removeMoving(proxy);
+    p.alive = false;
+    p.sleeping = false;
+    freeProxies.push_back(proxy);
+}
+
+void Broadphase::removeMoving(int proxy) {
+    Proxy& p = proxies[proxy];
+    int last = movingProxies.back();
+    movingProxies[p.movingIndex] = last;
+    proxies[last].movingIndex = p.movingIndex;
+    movingProxies.pop_back();
+    p.movingIndex = -1;
+}
+
+void Broadphase::setSleeping(int proxy, bool sleeping) {
+    Proxy& p = proxies[proxy];
+    if ((p.flags & PROXY_STATIC) || p.sleeping == sleeping) return;
+    p.sleeping = sleeping;
+    if (sleeping) {
+        removeMoving(proxy);
+    }
+    else {
+        p.movingIndex = static_cast<int>(movingProxies.size());
+        movingProxies.push_back(proxy);
+    }
+}
+
+void Broadphase::moveProxy(int proxy, const SDL_Rect& rect) {
+    Proxy& p = proxies[proxy];
+    int minX = toCell(rect.x), minY = toCell(rect.y);
+    int maxX = toCell(rect.x + std::max(rect.w, 1) - 1), maxY = toCell(rect.y + std::max(rect.h, 1) - 1);
+    if (minX == p.minCellX && minY == p.minCellY && maxX == p.maxCellX && maxY == p.maxCellY) {
+        p.rect = rect;  // Still in the same cells, nothing to rehash
+        return;
+    }
+    removeCells(proxy);
+    p.rect = rect;
+    insertCells(proxy);
+}
+
+void Broadphase::setCollisionFilter(int proxy, uint32_t layer, uint32_t mask) {
+    Proxy& p = proxies[proxy];
+    for (int y = p.minCellY; y <= p.maxCellY; ++y) {
+        for (int x = p.minCellX; x <= p.maxCellX; ++x) {
+            for (CellEntry& entry : buckets[bucketIndex(x, y)]) {
+                if (entry.proxy == proxy && entry.cellX == x && entry.cellY == y) {
+                    entry.layer = layer;
+                    entry.mask = mask;
+                }
+            }
+        }
+    }
+    p.layer = layer;
+    p.mask = mask;
+}
+
+void Broadphase::findPairs(std::vector<ProxyPair>& pairs) const {
+    pairs.clear();
+    for (int a : movingProxies) {
+        const Proxy& pa = proxies[a];
+        if (!pa.mask) continue;  // Collides with nothing
+        for (int y = pa.minCellY; y <= pa.maxCellY; ++y) {
+            for (int x = pa.minCellX; x <= pa.maxCellX; ++x) {
+                for (const CellEntry& entry : buckets[bucketIndex(x, y)]) {
+                    if (entry.cellX != x || entry.cellY != y) continue;  // Another cell in the same bucket
+                    if (!(entry.layer & pa.mask) || !(pa.layer & entry.mask)) continue;
+                    int b = entry.proxy;
+                    const Proxy& pb = proxies[b];
+                    // Pairs of awake proxies are reported from the lower proxy only
+                    if (pb.movingIndex >= 0 && b <= a) continue;
+                    if (!rectsOverlap(pa.rect, pb.rect)) continue;
+
+                    // Proxies sharing several cells are reported only from the cell
+                    // holding the top-left corner of their intersection
+                    int cornerX = toCell(std::max(pa.rect.x, pb.rect.x));
+                    int cornerY = toCell(std::max(pa.rect.y, pb.rect.y));
+                    if (cornerX != x || cornerY != y) continue;
+
+                    pairs.push_back({ a, b });
+                }
+            }
+        }
+    }
+}
+
+// Squared distance from a point to the nearest point of a rectangle (0 inside it)
+static float rectDistanceSquared(const SDL_Rect& rect, float x, float y) {
+    float dx = std::max({ static_cast<float>(rect.x) - x, 0.0f, x - static_cast<float>(rect.x + rect.w) });
+    float dy = std::max({ static_cast<float>(rect.y) - y, 0.0f, y - static_cast<float>(rect.y + rect.h) });
+    return dx * dx + dy * dy;
+}
+
+// Slab test of the segment (x0, y0) + t * (dx, dy), t in [0, 1], against a rectangle
+static bool rayEntry(float x0, float y0, float dx, float dy, const SDL_Rect& rect, float& time) {
+    float enter = 0.0f, leave = 1.0f;
+    const float origin[2] = { x0, y0 }, direction[2] = { dx, dy };
+    const float low[2] = { static_cast<float>(rect.x), static_cast<float>(rect.y) };
+    const float high[2] = { static_cast<float>(rect.x + rect.w), static_cast<float>(rect.y + rect.h) };
+    for (int axis = 0; axis < 2; ++axis) {
+        if (direction[axis] == 0.0f) {
+            if (origin[axis] < low[axis] || origin[axis] > high[axis]) return false;
+            continue;
+        }
+        float near = (low[axis] - origin[axis]) / direction[axis];
+        float far = (high[axis] - origin[axis]) / direction[axis];
+        if (near > far) std::swap(near, far);
+        enter = std::max(enter, near);
+        leave = std::min(leave, far);
+        if (enter > leave) return false;
+    }
+    time = enter;
+    return true;
+}
+
+// Calls visit(proxy) once for every proxy that passes the filter and overlaps the area
+template <typename Visit>
+void Broadphase::visitRegion(const SDL_Rect& area, const QueryFilter& filter, Visit&& visit) const {
+    const int minX = toCell(area.x), minY = toCell(area.y);
+    const int maxX = toCell(area.x + std::max(area.w, 1) - 1), maxY = toCell(area.y + std::max(area.h, 1) - 1);
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            for (const CellEntry& entry : buckets[bucketIndex(x, y)]) {
+                if (entry.cellX != x || entry.cellY != y) continue;
+                if (!(entry.layer & filter.mask) || entry.proxy == filter.ignoreProxy) continue;
+                const SDL_Rect& rect = proxies[entry.proxy].rect;
+                if (!rectsOverlap(rect, area)) continue;
+                // Same rule as findPairs: report from the cell holding the intersection's top-left corner
+                if (toCell(std::max(rect.x, area.x)) != x || toCell(std::max(rect.y, area.y)) != y) continue;
+                visit(entry.proxy);
+            }
+        }
+    }
+}
+
+// Steps through the cells crossed by the segment in order (Amanatides-Woo). visit(cellX, cellY, exitTime)
+// gets the time the ray leaves the cell and returns false to stop early.
+template <typename Visit>
+void Broadphase::walkRay(float x0, float y0, float x1, float y1, Visit&& visit) const {
+    const float size = static_cast<float>(cellSize);
+    const float infinity = std::numeric_limits<float>::infinity();
+    const float dx = x1 - x0, dy = y1 - y0;
+    int cellX = static_cast<int>(std::floor(x0 / size)), cellY = static_cast<int>(std::floor(y0 / size));
+    const int endX = static_cast<int>(std::floor(x1 / size)), endY = static_cast<int>(std::floor(y1 / size));
+    const int stepX = dx > 0.0f ? 1 : -1, stepY = dy > 0.0f ? 1 : -1;
+    float nextX = dx == 0.0f ? infinity : ((cellX + (dx > 0.0f ? 1 : 0)) * size - x0) / dx;
+    float nextY = dy == 0.0f ? infinity : ((cellY + (dy > 0.0f ? 1 : 0)) * size - y0) / dy;
+    const float deltaX = dx == 0.0f ? infinity : size / std::abs(dx);
+    const float deltaY = dy == 0.0f ? infinity : size / std::abs(dy);
+
+    // Exactly one cell boundary is crossed per step, so the step count is known up front
+    const int steps = std::abs(endX - cellX) + std::abs(endY - cellY);
+    for (int step = 0; step <= steps; ++step) {
+        if (!visit(cellX, cellY, std::min({ nextX, nextY, 1.0f }))) return;
+        if (nextX < nextY) {
+            cellX += stepX;
+            nextX += deltaX;
+        }
+        else {
+            cellY += stepY;
+            nextY += deltaY;
+        }
+    }
+}
+
+int Broadphase::queryRegion(const SDL_Rect& area, std::span<int> results, const QueryFilter& filter) const {
+    int count = 0;
+    visitRegion(area, filter, [&](int proxy) {
+        if (count < static_cast<int>(results.size())) results[count] = proxy;
+        ++count;
+    });
+    return count;
+}
+
+int Broadphase::queryRadius(float x, float y, float radius, std::span<int> results, const QueryFilter& filter) const {
+    // One pixel of slack so rects just touching the circle still overlap the bounds
+    const int minX = static_cast<int>(std::floor(x - radius)) - 1, minY = static_cast<int>(std::floor(y - radius)) - 1;
+    const int maxX = static_cast<int>(std::ceil(x + radius)) + 1, maxY = static_cast<int>(std::ceil(y + radius)) + 1;
+    const SDL_Rect bounds = { minX, minY, maxX - minX, maxY - minY };
+    int count = 0;
+    visitRegion(bounds, filter, [&](int proxy) {
+        if (rectDistanceSquared(proxies[proxy].rect, x, y) > radius * radius) return;
+        if (count < static_cast<int>(results.size())) results[count] = proxy;
+        ++count;
+    });
+    return count;
+}
+
+bool Broadphase::raycast(float x0, float y0, float x1, float y1, RaycastHit& hit, const QueryFilter& filter) const {
+    hit = { -1, std::numeric_limits<float>::infinity() };
+    walkRay(x0, y0, x1, y1, [&](int cellX, int cellY, float exitTime) {
+        for (const CellEntry& entry : buckets[bucketIndex(cellX, cellY)]) {
+            if (entry.cellX != cellX || entry.cellY != cellY) continue;
+            if (!(entry.layer & filter.mask) || entry.proxy == filter.ignoreProxy) continue;
+            float time;
+            if (rayEntry(x0, y0, x1 - x0, y1 - y0, proxies[entry.proxy].rect, time) && time < hit.time) {
+                hit = { entry.proxy, time };
+            }
+        }
+        // Anything in a later cell is entered after this cell is left
+        return hit.proxy < 0 || hit.time > exitTime;
+    });
+    return hit.proxy >= 0;
+}
+
+int Broadphase::raycastAll(float x0, float y0, float x1, float y1, std::span<RaycastHit> hits, const QueryFilter& filter) const {
+    const int capacity = static_cast<int>(hits.size());
+    if (capacity == 0) return 0;
+    int count = 0, farthest = 0;  // When full, new hits replace the farthest one
+    walkRay(x0, y0, x1, y1, [&](int cellX, int cellY, float exitTime) {
+        for (const CellEntry& entry : buckets[bucketIndex(cellX, cellY)]) {
+            if (entry.cellX != cellX || entry.cellY != cellY) continue;
+            if (!(entry.layer & filter.mask) || entry.proxy == filter.ignoreProxy) continue;
+            float time;
+            if (!rayEntry(x0, y0, x1 - x0, y1 - y0, proxies[entry.proxy].rect, time)) continue;
+            // Proxies spanning several cells show up once per cell
+            bool seen = false;
+            for (int i = 0; i < count && !seen; ++i) seen = hits[i].proxy == entry.proxy;
+            if (seen) continue;
+
+            if (count < capacity) {
+                hits[count++] = { entry.proxy, time };
+            }
+            else if (time < hits[farthest].time) {
+                hits[farthest] = { entry.proxy, time };
+            }
+            else {
+                continue;
+            }
+            if (count == capacity) {
+                farthest = 0;
+                for (int i = 1; i < count; ++i) {
+                    if (hits[i].time > hits[farthest].time) farthest = i;
+                }
+            }
+        }
+        return count < capacity || hits[farthest].time > exitTime;
+    });
+    std::sort(hits.begin(), hits.begin() + count, [](const RaycastHit& a, const RaycastHit& b) { return a.time < b.time; });
+    return count;
+}
+
+int Broadphase::queryNearest(float x, float y, float maxDistance, std::span<int> results, const QueryFilter& filter) const {
+    const int capacity = static_cast<int>(results.size());
+    if (capacity == 0) return 0;
+    const float size = static_cast<float>(cellSize);
+    const int centreX = static_cast<int>(std::floor(x / size)), centreY = static_cast<int>(std::floor(y / size));
+    const int maxRing = static_cast<int>(std::ceil(maxDistance / size)) + 1;
+    int count = 0;  // results[0, count) is kept sorted by distance
+
+    auto visitCell = [&](int cellX, int cellY) {
+        for (const CellEntry& entry : buckets[bucketIndex(cellX, cellY)]) {
+            if (entry.cellX != cellX || entry.cellY != cellY) continue;
+            if (!(entry.layer & filter.mask) || entry.proxy == filter.ignoreProxy) continue;
+            float distance = rectDistanceSquared(proxies[entry.proxy].rect, x, y);
+            if (distance > maxDistance * maxDistance) continue;
+            bool seen = false;
+            for (int i = 0; i < count && !seen; ++i) seen = results[i] == entry.proxy;
+            if (seen) continue;
+
+            int slot;
+            if (count < capacity) {
+                slot = count++;
+            }
+            else if (distance < rectDistanceSquared(proxies[results[capacity - 1]].rect, x, y)) {
+                slot = capacity - 1;
+            }
+            else {
+                continue;
+            }
+            while (slot > 0 && rectDistanceSquared(proxies[results[slot - 1]].rect, x, y) > distance) {
+                results[slot] = results[slot - 1];
+                --slot;
+            }
+            results[slot] = entry.proxy;
+        }
+    };
+
+    // Square rings of cells around the point, closest first
+    for (int ring = 0; ring <= maxRing; ++ring) {
+        if (ring == 0) {
+            visitCell(centreX, centreY);
+        }
+        else {
+            for (int cellX = centreX - ring; cellX <= centreX + ring; ++cellX) {
+                visitCell(cellX, centreY - ring);
+                visitCell(cellX, centreY + ring);
+            }
+            for (int cellY = centreY - ring + 1; cellY < centreY + ring; ++cellY) {
+                visitCell(centreX - ring, cellY);
+                visitCell(centreX + ring, cellY);
+            }
+        }
+        // Proxies not seen yet lie outside the rings, at least this far away
+        float outside = std::min({ x - (centreX - ring) * size, (centreX + ring + 1) * size - x,
+                                   y - (centreY - ring) * size, (centreY + ring + 1) * size - y });
+        if (outside > maxDistance) break;
+        if (count == capacity && rectDistanceSquared(proxies[results[capacity - 1]].rect, x, y) <= outside * outside) break;
+    }
+    return count;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <SDL.h>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Proxy flags
+enum ProxyFlags {
+    PROXY_STATIC = 1 << 0,   // Never moves on its own; only paired with non-static proxies
+    PROXY_TRIGGER = 1 << 1   // Reports overlaps but is not solid
+};
+
+// Collision filtering: a proxy sits on one or more layer bits and its mask says which layers it
+// collides with. Two proxies pair up only if each one's layer is in the other's mask.
+const uint32_t COLLISION_DEFAULT_LAYER = 1u;
+const uint32_t COLLISION_ALL = 0xFFFFFFFFu;
+
+// Two overlapping proxies. First is always an awake, non-static proxy.
+struct ProxyPair {
+    int a, b;
+};
+
+// Which proxies a spatial query may return: those on a layer in mask, except ignoreProxy
+// (usually the asker itself)
+struct QueryFilter {
+    uint32_t mask = COLLISION_ALL;
+    int ignoreProxy = -1;
+};
+
+// A proxy crossed by a ray; time is the fraction of the ray where it enters the proxy
+// (0 when the ray starts inside it)
+struct RaycastHit {
+    int proxy = -1;
+    float time = 0.0f;
+};
+
+// Spatial hash over a uniform grid of cells, used to find overlapping rectangles
+// without testing every pair. Pairs are generated from the awake non-static proxies only,
+// so static proxies (walls, triggers) and sleeping ones cost nothing while nothing moves
+// near them; an awake proxy still pairs with the sleeping ones it touches.
+class Broadphase {
+public:
+    explicit Broadphase(int cellSize = 64, int bucketCount = 4096);
+
+    int createProxy(const SDL_Rect& rect, int userData, int flags = 0, uint32_t layer = COLLISION_DEFAULT_LAYER,
+                    uint32_t mask = COLLISION_ALL);
+    void destroyProxy(int proxy);
+    void moveProxy(int proxy, const SDL_Rect& rect);  // Cheap when the proxy stays in the same cells
+    void setCollisionFilter(int proxy, uint32_t layer, uint32_t mask);
+    void setSleeping(int proxy, bool sleeping);  // Ignored for static proxies
+    bool isSleeping(int proxy) const { return proxies[proxy].sleeping; }
+
+    void setUserData(int proxy, int userData) { proxies[proxy].userData = userData; }
+    int getUserData(int proxy) const { return proxies[proxy].userData; }
+    int getFlags(int proxy) const { return proxies[proxy].flags; }
+    const SDL_Rect& getRect(int proxy) const { return proxies[proxy].rect; }
+    uint32_t getLayer(int proxy) const { return proxies[proxy].layer; }
+    uint32_t getMask(int proxy) const { return proxies[proxy].mask; }
+    bool isAlive(int proxy) const { return proxy >= 0 && proxy < static_cast<int>(proxies.size()) && proxies[proxy].alive; }
+
+    // Collects every overlapping pair whose layers collide, each reported once
+    void findPairs(std::vector<ProxyPair>& pairs) const;
+
+    // Gameplay queries. They only visit the cells the query shape covers and never allocate,
+    // so many can run side by side on the workers (see SpatialQuery.h). Region and radius
+    // queries return how many proxies matched; only the first results.size() are written.
+    int queryRegion(const SDL_Rect& area, std::span<int> results, const QueryFilter& filter = {}) const;
+    int queryRadius(float x, float y, float radius, std::span<int> results, const QueryFilter& filter = {}) const;
+    // Nearest proxy crossed going from (x0, y0) to (x1, y1)
+    bool raycast(float x0, float y0, float x1, float y1, RaycastHit& hit, const QueryFilter& filter = {}) const;
+    // The hits.size() nearest proxies crossed by the ray, sorted by time; returns how many were written
+    int raycastAll(float x0, float y0, float x1, float y1, std::span<RaycastHit> hits, const QueryFilter& filter = {}) const;
+    // The results.size() proxies closest to the point (by distance to their rect) within maxDistance,
+    // nearest first; returns how many were written
+    int queryNearest(float x, float y, float maxDistance, std::span<int> results, const QueryFilter& filter = {}) const;
+
+    int getCellSize() const { return cellSize; }
+    int getProxyCount() const { return static_cast<int>(proxies.size() - freeProxies.size()); }
+
+private:
+    struct Proxy {
+        SDL_Rect rect;
+        int minCellX, minCellY, maxCellX, maxCellY;  // Cells currently covered
+        int userData;
+        int flags;
+        uint32_t layer, mask;
+        int movingIndex;  // Position in movingProxies, or -1 for static and sleeping proxies
+        bool sleeping;
+        bool alive;
+    };
+
+    // A proxy stored in a hash bucket for one cell. Several cells can share a bucket,
+    // so the cell coordinates are kept to tell them apart. The collision filter is copied
+    // in too, so pairs between layers that never interact are dropped without touching the proxy.
+    struct CellEntry {
+        int cellX, cellY;
+        int proxy;
+        uint32_t layer, mask;
+    };
+
+    int cellSize;
+    std::vector<Proxy> proxies;
+    std::vector<int> freeProxies;
+    std::vector<int> movingProxies;  // Awake non-static proxies, drive pair generation
+    std::vector<std::vector<CellEntry>> buckets;
+
+    size_t bucketIndex(int cellX, int cellY) const;
+    int toCell(int coordinate) const;
+    void insertCells(int proxy);
+    void removeCells(int proxy);
+    void removeMoving(int proxy);
+    template <typename Visit>
+    void visitRegion(const SDL_Rect& area, const QueryFilter& filter, Visit&& visit) const;
+    template <typename Visit>
+    void walkRay(float x0, float y0, float x1, float y1, Visit&& visit) const;
+};
+
+// Checks if two rectangles are overlapping
+inline bool rectsOverlap(const SDL_Rect& a, const SDL_Rect& b) {
+    return a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y;
+}
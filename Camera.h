@@ -0,0 +1,23 @@
+#pragma once
+#include <SDL.h>
+
+// 2D camera looking at a point in the world with a zoom factor
+struct Camera {
+    float x = 0.0f, y = 0.0f;  // World position shown at the centre of the screen
+    float zoom = 1.0f;         // Screen pixels per world pixel
+    int screenWidth = 0, screenHeight = 0;
+
+    // Converts a world rectangle to screen coordinates
+    SDL_FRect worldToScreen(const SDL_Rect& rect) const {
+        return { (rect.x - x) * zoom + screenWidth * 0.5f,
+                 (rect.y - y) * zoom + screenHeight * 0.5f,
+                 rect.w * zoom, rect.h * zoom };
+    }
+
+    // True if a world rectangle is at least partly on screen
+    bool isVisible(const SDL_Rect& rect) const {
+        SDL_FRect screen = worldToScreen(rect);
+        return screen.x < screenWidth && screen.y < screenHeight &&
+            screen.x + screen.w > 0 && screen.y + screen.h > 0;
+    }
+};
@@ -0,0 +1,62 @@
+#include "CollisionMask.h"
+#include <algorithm>
+#include <iostream>
+
+bool createCollisionMask(SDL_Surface* image, int width, int height, Uint8 alphaThreshold, CollisionMask& mask) {
+    mask = CollisionMask();
+    if (!image || width <= 0 || height <= 0) return false;
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!rgba) {
+        std::cerr << "Failed to build collision mask: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    mask.width = width;
+    mask.height = height;
+    mask.wordsPerRow = (width + 63) / 64 + 1;
+    mask.bits.assign(static_cast<size_t>(mask.wordsPerRow) * height, 0);
+    int minX = width, minY = height, maxX = -1, maxY = -1;
+    for (int y = 0; y < height; ++y) {
+        const Uint8* row = static_cast<const Uint8*>(rgba->pixels) + (y * rgba->h / height) * rgba->pitch;
+        for (int x = 0; x < width; ++x) {
+            if (row[(x * rgba->w / width) * 4 + 3] < alphaThreshold) continue;
+            mask.bits[static_cast<size_t>(y) * mask.wordsPerRow + (x >> 6)] |= uint64_t(1) << (x & 63);
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+        }
+    }
+    if (maxX >= 0) mask.solidBounds = { minX, minY, maxX - minX + 1, maxY - minY + 1 };
+    SDL_FreeSurface(rgba);
+    return true;
+}
+
+// 64 mask bits starting at pixel x of a row (x >= 0); relies on the spare word at the end of each row
+static uint64_t readBits(const uint64_t* row, int x) {
+    int word = x >> 6;
+    int shift = x & 63;
+    return shift ? (row[word] >> shift) | (row[word + 1] << (64 - shift)) : row[word];
+}
+
+bool masksOverlap(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by) {
+    if (a.bits.empty() || b.bits.empty()) return true;
+
+    // Only the overlap of the two solid boxes can contain a hit
+    int left = std::max(ax + a.solidBounds.x, bx + b.solidBounds.x);
+    int top = std::max(ay + a.solidBounds.y, by + b.solidBounds.y);
+    int right = std::min(ax + a.solidBounds.x + a.solidBounds.w, bx + b.solidBounds.x + b.solidBounds.w);
+    int bottom = std::min(ay + a.solidBounds.y + a.solidBounds.h, by + b.solidBounds.y + b.solidBounds.h);
+    if (left >= right || top >= bottom) return false;
+
+    for (int y = top; y < bottom; ++y) {
+        const uint64_t* rowA = &a.bits[static_cast<size_t>(y - ay) * a.wordsPerRow];
+        const uint64_t* rowB = &b.bits[static_cast<size_t>(y - by) * b.wordsPerRow];
+        for (int x = left; x < right; x += 64) {
+            uint64_t overlap = readBits(rowA, x - ax) & readBits(rowB, x - bx);
+            if (right - x < 64) overlap &= (uint64_t(1) << (right - x)) - 1;
+            if (overlap) return true;
+        }
+    }
+    return false;
+}
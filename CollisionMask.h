@@ -0,0 +1,27 @@
+#pragma once
+#include <SDL.h>
+#include <cstdint>
+#include <vector>
+
+// 1-bit opacity mask of a sprite image at the size it is drawn, 64 pixels per word.
+// Each row has a spare zero word at the end so shifted reads never need a bounds check.
+struct CollisionMask {
+    int width = 0, height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+    SDL_Rect solidBounds = { 0, 0, 0, 0 };  // Tight box around the set bits, in mask pixels
+
+    bool test(int x, int y) const {
+        if (x < 0 || y < 0 || x >= width || y >= height) return false;
+        return (bits[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+};
+
+// Builds a mask from image alpha, scaled (nearest pixel) to width x height. Pixels with
+// alpha of at least alphaThreshold are solid. Returns false if the image can't be read.
+bool createCollisionMask(SDL_Surface* image, int width, int height, Uint8 alphaThreshold, CollisionMask& mask);
+
+// Pixel-exact overlap test for two masks placed at (ax, ay) and (bx, by). Rows are
+// compared a word at a time by AND'ing b's row shifted into a's alignment.
+// An empty mask (one that failed to load) counts as fully solid.
+bool masksOverlap(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by);
@@ -0,0 +1,165 @@
+#include "DepthSort.h"
+#include <algorithm>
+
+// Sprites are ordered by where their feet touch the ground
+static int depthKey(const Sprite& sprite) {
+    return sprite.rect.y + sprite.rect.h;
+}
+
+const std::vector<int>& DepthSorter::sort(const std::vector<Sprite>& sprites) {
+    const int count = static_cast<int>(sprites.size());
+    const bool removed = removalsPending;
+    if (removed) applyRemovals(count);
+
+    // Refresh keys of sprites we already know, in last frame's order
+    const int known = static_cast<int>(order.size());
+    for (int i = 0; i < known; ++i) {
+        keys[i] = depthKey(sprites[order[i]]);
+    }
+
+    // Sprites added since the last sort are collected separately. Without removals they are
+    // the ones appended past the known count; removals may have moved them anywhere.
+    newOrder.clear();
+    newKeys.clear();
+    for (int index = removed ? 0 : known; index < count; ++index) {
+        if (removed && sorted[index]) continue;
+        newOrder.push_back(index);
+        newKeys.push_back(depthKey(sprites[index]));
+    }
+
+    // Repair last frame's order; give up on insertion sort if disorder turns out to be high
+    lastMoves = 0;
+    lastUsedRadix = false;
+    if (!insertionSort(known, 4 * known + 64)) {
+        radixSort();
+        lastUsedRadix = true;
+    }
+
+    if (!newOrder.empty()) mergeNewEntries();
+    return order;
+}
+
+void DepthSorter::onSpriteRemoved(int index, int last) {
+    // Sprites only grow between removals. At the first removal every index still holds itself;
+    // sprites appended after that are not in the order yet (-1).
+    const bool first = !removalsPending;
+    if (first) slots.clear();
+    for (int i = static_cast<int>(slots.size()); i <= last; ++i) {
+        slots.push_back(first ? i : -1);
+    }
+    slots[index] = slots[last];
+    slots.pop_back();
+    removalsPending = true;
+}
+
+void DepthSorter::applyRemovals(int spriteCount) {
+    // Only indices below order.size() are in the order; larger ones were appended after the last sort
+    const int known = static_cast<int>(order.size());
+    remap.assign(known, -1);
+    for (size_t current = 0; current < slots.size(); ++current) {
+        if (slots[current] >= 0 && slots[current] < known) remap[slots[current]] = static_cast<int>(current);
+    }
+
+    // Drop removed entries and rename moved ones, keeping the relative order intact
+    sorted.assign(spriteCount, 0);
+    int write = 0;
+    for (size_t read = 0; read < order.size(); ++read) {
+        int sprite = remap[order[read]];
+        if (sprite < 0) continue;
+        order[write] = sprite;
+        keys[write] = keys[read];
+        sorted[sprite] = 1;
+        ++write;
+    }
+    order.resize(write);
+    keys.resize(write);
+    removalsPending = false;
+}
+
+bool DepthSorter::insertionSort(int count, int moveBudget) {
+    for (int i = 1; i < count; ++i) {
+        int key = keys[i];
+        if (keys[i - 1] <= key) continue;  // Already in place, the common case
+
+        int sprite = order[i];
+        int j = i;
+        while (j > 0 && keys[j - 1] > key) {
+            keys[j] = keys[j - 1];
+            order[j] = order[j - 1];
+            --j;
+        }
+        keys[j] = key;
+        order[j] = sprite;
+
+        lastMoves += i - j;
+        if (lastMoves > moveBudget) return false;  // Too disordered, the order is still a valid permutation
+    }
+    return true;
+}
+
+void DepthSorter::radixSort() {
+    const int count = static_cast<int>(order.size());
+    if (count < 2) return;
+
+    // Sort on unsigned offsets from the smallest key so negative positions work
+    int minKey = keys[0], maxKey = keys[0];
+    for (int key : keys) {
+        minKey = std::min(minKey, key);
+        maxKey = std::max(maxKey, key);
+    }
+    const unsigned range = static_cast<unsigned>(maxKey - minKey);
+
+    scratchOrder.resize(count);
+    scratchKeys.resize(count);
+
+    // Stable LSD passes over 8-bit digits, skipping digits above the key range
+    for (unsigned shift = 0; shift < 32 && (range >> shift) != 0; shift += 8) {
+        int counts[257] = {};
+        for (int i = 0; i < count; ++i) {
+            counts[((static_cast<unsigned>(keys[i] - minKey) >> shift) & 0xFF) + 1]++;
+        }
+        for (int d = 0; d < 256; ++d) {
+            counts[d + 1] += counts[d];
+        }
+        for (int i = 0; i < count; ++i) {
+            int dest = counts[(static_cast<unsigned>(keys[i] - minKey) >> shift) & 0xFF]++;
+            scratchOrder[dest] = order[i];
+            scratchKeys[dest] = keys[i];
+        }
+        order.swap(scratchOrder);
+        keys.swap(scratchKeys);
+    }
+}
+
+void DepthSorter::mergeNewEntries() {
+    // New sprites are few, so a plain insertion sort is enough for them
+    for (size_t i = 1; i < newOrder.size(); ++i) {
+        int key = newKeys[i], sprite = newOrder[i];
+        size_t j = i;
+        while (j > 0 && newKeys[j - 1] > key) {
+            newKeys[j] = newKeys[j - 1];
+            newOrder[j] = newOrder[j - 1];
+            --j;
+        }
+        newKeys[j] = key;
+        newOrder[j] = sprite;
+    }
+
+    // Merge the two sorted lists; existing sprites win ties so they keep their place
+    const size_t total = order.size() + newOrder.size();
+    scratchOrder.resize(total);
+    scratchKeys.resize(total);
+    size_t a = 0, b = 0;
+    for (size_t out = 0; out < total; ++out) {
+        if (b >= newOrder.size() || (a < order.size() && keys[a] <= newKeys[b])) {
+            scratchOrder[out] = order[a];
+            scratchKeys[out] = keys[a++];
+        }
+        else {
+            scratchOrder[out] = newOrder[b];
+            scratchKeys[out] = newKeys[b++];
+        }
+    }
+    order.swap(scratchOrder);
+    keys.swap(scratchKeys);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "Sprite.h"
+
+// Keeps sprites in draw order by the y of their bottom edge (top-down depth).
+// The order from the previous frame is kept and repaired, since sprites only move
+// a few pixels per frame: an insertion sort fixes small disorder in near-linear time,
+// newly spawned sprites are sorted on their own and merged in, and a radix sort takes
+// over when the insertion sort would do too much work.
+class DepthSorter {
+public:
+    // Updates the draw order for the current sprites and returns it (indices into sprites)
+    const std::vector<int>& sort(const std::vector<Sprite>& sprites);
+
+    // Keeps stored indices valid after sprites[index] = sprites[last]; sprites.pop_back().
+    // Constant time; the order is patched up in one pass by the next sort.
+    void onSpriteRemoved(int index, int last);
+
+    const std::vector<int>& getOrder() const { return order; }
+
+    // Stats from the last sort (for the debug UI)
+    int getLastMoves() const { return lastMoves; }
+    bool usedRadixSort() const { return lastUsedRadix; }
+
+private:
+    std::vector<int> order;  // Sprite indices in draw order
+    std::vector<int> keys;   // Depth key of each entry in order
+
+    // Removals since the last sort: which sprite index from the last sort each current index holds
+    std::vector<int> slots;
+    std::vector<int> remap;          // Sprite index from the last sort -> current index, or -1
+    std::vector<unsigned char> sorted;  // Per current sprite, whether it is already in order
+    bool removalsPending = false;
+
+    // Scratch buffers reused between frames
+    std::vector<int> scratchOrder;
+    std::vector<int> scratchKeys;
+    std::vector<int> newOrder;
+    std::vector<int> newKeys;
+
+    int lastMoves = 0;
+    bool lastUsedRadix = false;
+
+    void applyRemovals(int spriteCount);
+    bool insertionSort(int count, int moveBudget);
+    void radixSort();
+    void mergeNewEntries();
+};
@@ -0,0 +1,177 @@
+#include "DirtyRects.h"
+#include <algorithm>
+#include <iostream>
+
+// Above this fraction of dirty cells a single full-screen region is cheaper than many small ones
+static const float FULL_REDRAW_FRACTION = 0.6f;
+
+static bool rectsEqual(const SDL_Rect& a, const SDL_Rect& b) {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+DirtyRectTracker::DirtyRectTracker(int width, int height, int cellSize)
+    : width(width), height(height), cellSize(cellSize),
+      cols((width + cellSize - 1) / cellSize), rows((height + cellSize - 1) / cellSize),
+      dirtyCells(0), anyDirty(false), cells(cols * rows, 0) {
+}
+
+void DirtyRectTracker::markDirty(const SDL_Rect& rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+    if (rect.x >= width || rect.y >= height || rect.x + rect.w <= 0 || rect.y + rect.h <= 0) return;
+
+    // Clamp the rectangle to the cell grid
+    int x0 = std::max(rect.x, 0) / cellSize;
+    int y0 = std::max(rect.y, 0) / cellSize;
+    int x1 = (std::min(rect.x + rect.w, width) - 1) / cellSize;
+    int y1 = (std::min(rect.y + rect.h, height) - 1) / cellSize;
+
+    for (int y = y0; y <= y1; ++y) {
+        unsigned char* row = &cells[y * cols];
+        for (int x = x0; x <= x1; ++x) {
+            dirtyCells += row[x] ^ 1;
+            row[x] = 1;
+        }
+    }
+    anyDirty = true;
+}
+
+void DirtyRectTracker::markAllDirty() {
+    std::fill(cells.begin(), cells.end(), 1);
+    dirtyCells = cols * rows;
+    anyDirty = true;
+}
+
+void DirtyRectTracker::clear() {
+    if (!anyDirty) return;
+    std::fill(cells.begin(), cells.end(), 0);
+    dirtyCells = 0;
+    anyDirty = false;
+}
+
+const std::vector<SDL_Rect>& DirtyRectTracker::buildRegions() {
+    regions.clear();
+    if (!anyDirty) return regions;
+
+    if (dirtyCells >= static_cast<int>(FULL_REDRAW_FRACTION * cols * rows)) {
+        regions.push_back({ 0, 0, width, height });
+        return regions;
+    }
+
+    // Collect horizontal runs per row and extend runs that match one from the row above
+    openRegions.clear();
+    for (int y = 0; y < rows; ++y) {
+        nextOpenRegions.clear();
+        const unsigned char* row = &cells[y * cols];
+        int x = 0;
+        while (x < cols) {
+            if (!row[x]) { ++x; continue; }
+            int start = x;
+            while (x < cols && row[x]) ++x;
+
+            // Regions are stored in cell units until the end
+            int match = -1;
+            for (int index : openRegions) {
+                if (regions[index].x == start && regions[index].w == x - start) {
+                    match = index;
+                    break;
+                }
+            }
+            if (match >= 0) {
+                regions[match].h++;
+            }
+            else {
+                match = static_cast<int>(regions.size());
+                regions.push_back({ start, y, x - start, 1 });
+            }
+            nextOpenRegions.push_back(match);
+        }
+        openRegions.swap(nextOpenRegions);
+    }
+
+    // Convert from cells to pixels, clamped to the screen
+    for (SDL_Rect& r : regions) {
+        r.x *= cellSize;
+        r.y *= cellSize;
+        r.w = std::min(r.w * cellSize, width - r.x);
+        r.h = std::min(r.h * cellSize, height - r.y);
+    }
+    return regions;
+}
+
+DirtyRectRenderer::DirtyRectRenderer(int width, int height)
+    : width(width), height(height), renderer(nullptr), backBuffer(nullptr), tracker(width, height),
+      lastRegionCount(0), lastDirtyPixels(0), lastSpriteDraws(0) {
+}
+
+DirtyRectRenderer::~DirtyRectRenderer() {
+    destroy();
+}
+
+bool DirtyRectRenderer::init(SDL_Renderer* targetRenderer) {
+    renderer = targetRenderer;
+    if (!SDL_RenderTargetSupported(renderer)) {
+        std::cerr << "Dirty-rect rendering unavailable: renderer has no render target support" << std::endl;
+        return false;
+    }
+    backBuffer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (!backBuffer) {
+        std::cerr << "Failed to create back buffer: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    tracker.markAllDirty();  // The back buffer starts with undefined contents
+    return true;
+}
+
+void DirtyRectRenderer::destroy() {
+    if (backBuffer) SDL_DestroyTexture(backBuffer);
+    backBuffer = nullptr;
+}
+
+void DirtyRectRenderer::render(std::vector<Sprite>& sprites, const std::vector<int>& drawOrder,
+                               const std::function<void()>& drawOverlays) {
+    // Anything that moved dirties both where it was and where it is now
+    for (Sprite& sprite : sprites) {
+        if (!rectsEqual(sprite.rect, sprite.lastDrawnRect)) {
+            tracker.markDirty(sprite.lastDrawnRect);
+            tracker.markDirty(sprite.rect);
+            sprite.lastDrawnRect = sprite.rect;
+        }
+    }
+
+    const std::vector<SDL_Rect>& dirty = tracker.buildRegions();
+    lastRegionCount = static_cast<int>(dirty.size());
+    lastDirtyPixels = 0;
+    lastSpriteDraws = 0;
+
+    if (!dirty.empty()) {
+        SDL_SetRenderTarget(renderer, backBuffer);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);  // Background is black
+        for (const SDL_Rect& region : dirty) {
+            SDL_RenderSetClipRect(renderer, &region);
+            SDL_RenderFillRect(renderer, &region);
+
+            // Redraw every sprite touching this region; the clip rect trims the rest
+            for (int index : drawOrder) {
+                const Sprite& sprite = sprites[index];
+                if (SDL_HasIntersection(&sprite.rect, &region)) {
+                    SDL_Texture* texture = getDrawTexture(sprite);
+                    SDL_SetTextureColorMod(texture, sprite.tint.r, sprite.tint.g, sprite.tint.b);  // Team colour
+                    SDL_RenderCopy(renderer, texture, getSourceRect(sprite), &sprite.rect);
+                    SDL_SetTextureColorMod(texture, 255, 255, 255);
+                    lastSpriteDraws++;
+                }
+            }
+            if (drawOverlays) drawOverlays();  // Clipped to the region like the sprites
+            lastDirtyPixels += region.w * region.h;
+        }
+        SDL_RenderSetClipRect(renderer, nullptr);
+        SDL_SetRenderTarget(renderer, nullptr);
+        tracker.clear();
+    }
+
+    SDL_RenderCopy(renderer, backBuffer, nullptr, nullptr);  // Present the back buffer
+}
+
+void markSpriteRemoved(DirtyRectTracker& tracker, const Sprite& sprite) {
+    tracker.markDirty(sprite.lastDrawnRect);
+}
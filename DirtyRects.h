@@ -0,0 +1,68 @@
+#pragma once
+#include <SDL.h>
+#include <functional>
+#include <vector>
+#include "Sprite.h"
+
+// Tracks which parts of the screen changed since the last frame.
+// Dirty areas are recorded on a coarse cell grid and merged into a few rectangles on request.
+class DirtyRectTracker {
+public:
+    DirtyRectTracker(int width, int height, int cellSize = 32);
+
+    void markDirty(const SDL_Rect& rect);  // Mark a screen region as needing a redraw
+    void markAllDirty();                   // Force a full redraw next frame
+    void clear();                          // Forget all dirty regions
+    bool isDirty() const { return anyDirty; }
+
+    // Builds merged dirty rectangles in screen pixels (valid until the next call)
+    const std::vector<SDL_Rect>& buildRegions();
+
+private:
+    int width, height;
+    int cellSize;
+    int cols, rows;
+    int dirtyCells;
+    bool anyDirty;
+    std::vector<unsigned char> cells;  // One flag per cell, row-major
+    std::vector<SDL_Rect> regions;
+    std::vector<int> openRegions;      // Regions that ended on the previous cell row
+    std::vector<int> nextOpenRegions;
+};
+
+// Redraws only the dirty parts of the scene into a persistent back buffer,
+// then copies the back buffer to the screen. Falls back to a full redraw when
+// the renderer does not support render targets.
+class DirtyRectRenderer {
+public:
+    DirtyRectRenderer(int width, int height);
+    ~DirtyRectRenderer();
+
+    bool init(SDL_Renderer* renderer);  // Creates the back buffer, returns false if unsupported
+    void destroy();
+
+    DirtyRectTracker& getTracker() { return tracker; }
+
+    // Marks moved sprites dirty, redraws dirty regions in draw order and copies the back buffer to the screen.
+    // drawOverlays runs once per dirty region after its sprites, with the clip rect set to the region;
+    // whatever it draws must mark its own changes dirty, like sprites do.
+    void render(std::vector<Sprite>& sprites, const std::vector<int>& drawOrder,
+                const std::function<void()>& drawOverlays = {});
+
+    // Stats from the last rendered frame (for the debug UI)
+    int getRegionCount() const { return lastRegionCount; }
+    int getDirtyPixels() const { return lastDirtyPixels; }
+    int getSpriteDraws() const { return lastSpriteDraws; }
+
+private:
+    int width, height;
+    SDL_Renderer* renderer;
+    SDL_Texture* backBuffer;
+    DirtyRectTracker tracker;
+    int lastRegionCount;
+    int lastDirtyPixels;
+    int lastSpriteDraws;
+};
+
+// Marks the area a sprite was last drawn at as dirty (call before removing the sprite)
+void markSpriteRemoved(DirtyRectTracker& tracker, const Sprite& sprite);
@@ -0,0 +1,114 @@
+#include "EventBus.h"
+#include <algorithm>
+
+struct EventBus::ThreadRings {
+    struct Claim {
+        uint64_t bus;
+        Ring* ring;
+        std::weak_ptr<RingSet> owner;
+    };
+    std::vector<Claim> claims;
+
+    ~ThreadRings() {
+        for (const Claim& claim : claims) {
+            // Events already written stay in the ring for the next dispatch
+            if (std::shared_ptr<RingSet> owner = claim.owner.lock()) claim.ring->claimed.store(false, std::memory_order_release);
+        }
+    }
+};
+
+EventBus::EventBus(int ringCapacity, int maxThreads)
+    : ringSet(std::make_shared<RingSet>(maxThreads)), handlers(static_cast<size_t>(EngineEventType::Count)) {
+    static std::atomic<uint64_t> nextId{ 0 };
+    id = nextId++;
+    // Round the capacity up to a power of two so indices wrap with a mask
+    uint32_t capacity = 1;
+    while (capacity < static_cast<uint32_t>(ringCapacity)) capacity <<= 1;
+    capacityMask = capacity - 1;
+}
+
+EventBus::Ring* EventBus::threadRing() {
+    thread_local ThreadRings threadRings;
+    for (const ThreadRings::Claim& claim : threadRings.claims) {
+        if (claim.bus == id) return claim.ring;
+    }
+
+    // First publish from this thread: forget buses that are gone and claim a free ring
+    std::vector<ThreadRings::Claim>& claims = threadRings.claims;
+    claims.erase(std::remove_if(claims.begin(), claims.end(),
+                                [](const ThreadRings::Claim& claim) { return claim.owner.expired(); }),
+                 claims.end());
+    for (Ring& ring : ringSet->rings) {
+        bool expected = false;
+        if (!ring.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) continue;
+        // dispatch() only reads the slots after seeing head move, which happens after this
+        if (!ring.slots) ring.slots.reset(new EngineEvent[capacityMask + 1]);
+        claims.push_back({ id, &ring, ringSet });
+        return &ring;
+    }
+    return nullptr;
+}
+
+void EventBus::subscribe(EngineEventType type, Handler handler) {
+    handlers[static_cast<size_t>(type)].push_back(std::move(handler));
+}
+
+bool EventBus::publish(const EngineEvent& event) {
+    Ring* threadOwned = threadRing();
+    if (!threadOwned) {
+        unregisteredDrops.fetch_add(1, std::memory_order_relaxed);  // More live threads than rings
+        return false;
+    }
+
+    Ring& ring = *threadOwned;
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    uint32_t tail = ring.tail.load(std::memory_order_acquire);
+    if (head - tail > capacityMask) {
+        ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+    ring.slots[head & capacityMask] = event;
+    ring.head.store(head + 1, std::memory_order_release);  // Publishes the slot to the consumer
+    ring.published.store(ring.published.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return true;
+}
+
+bool EventBus::publish(EngineEventType type, int a, int b, float x, float y, int value) {
+    return publish(EngineEvent{ type, 0, a, b, x, y, value });
+}
+
+int EventBus::dispatch() {
+    int count = 0;
+    for (Ring& ring : ringSet->rings) {
+        uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+        uint32_t head = ring.head.load(std::memory_order_acquire);
+        if (tail == head) continue;
+
+        // Events published while handlers run land after head and wait for the next dispatch
+        for (; tail != head; ++tail) {
+            const EngineEvent& event = ring.slots[tail & capacityMask];
+            for (const Handler& handler : handlers[static_cast<size_t>(event.type)]) {
+                handler(event);
+            }
+            ++count;
+        }
+        ring.tail.store(tail, std::memory_order_release);
+    }
+    return count;
+}
+
+uint64_t EventBus::getPublished() const {
+    uint64_t total = 0;
+    for (const Ring& ring : ringSet->rings) {
+        total += ring.published.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t EventBus::getDropped() const {
+    uint64_t total = unregisteredDrops.load(std::memory_order_relaxed);
+    for (const Ring& ring : ringSet->rings) {
+        total += ring.dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Kinds of messages systems send each other
+enum class EngineEventType : uint16_t {
+    CollisionHit,  // a and b collided
+    TriggerEnter,  // a entered trigger b
+    TriggerStay,   // a is inside trigger b
+    TriggerExit,   // a left trigger b
+    Spawn,         // a was created at (x, y)
+    Death,         // a was removed at (x, y)
+    Custom,        // Game-defined, meaning given by value
+    Count
+};
+
+// Fixed-size event, copied by value into ring buffers
+struct EngineEvent {
+    EngineEventType type;
+    uint16_t flags;
+    int a, b;      // Entities, proxies or triggers involved (-1 if unused)
+    float x, y;    // Position, if any
+    int value;     // Extra payload
+};
+
+// Cross-thread event bus. Every producing thread writes into its own single-producer
+// ring buffer without locks or allocation; the owning thread drains all rings in
+// dispatch(), which the game calls at a fixed point in the frame. Handlers run there,
+// on the dispatching thread, in ring order. A thread claims one of this bus's rings the
+// first time it publishes (allocating the ring's slots if nobody used it before) and
+// gives it back when it exits.
+class EventBus {
+public:
+    using Handler = std::function<void(const EngineEvent&)>;
+
+    explicit EventBus(int ringCapacity = 1 << 14, int maxThreads = 16);
+
+    // Handlers are registered up front; dispatch() looks them up per event type
+    void subscribe(EngineEventType type, Handler handler);
+
+    // Wait-free from any thread. Returns false and counts a drop if the thread's ring is full.
+    bool publish(const EngineEvent& event);
+    bool publish(EngineEventType type, int a, int b = -1, float x = 0.0f, float y = 0.0f, int value = 0);
+
+    // Drains every ring and calls the handlers. Call from one thread only.
+    int dispatch();
+
+    uint64_t getPublished() const;
+    uint64_t getDropped() const;
+
+private:
+    // Single-producer single-consumer ring. Producer and consumer counters sit on
+    // separate cache lines so the two threads never write the same line.
+    struct Ring {
+        alignas(64) std::atomic<uint32_t> head{ 0 };      // Next slot to write (producer)
+        std::atomic<uint64_t> published{ 0 };             // Written by the producer only
+        std::atomic<uint64_t> dropped{ 0 };
+        alignas(64) std::atomic<uint32_t> tail{ 0 };      // Next slot to read (consumer)
+        std::atomic<bool> claimed{ false };               // Owned by a live producer thread
+        std::unique_ptr<EngineEvent[]> slots;             // Allocated by the first thread to claim the ring
+    };
+
+    // Rings are shared with the threads that claimed them, so a thread that outlives the bus
+    // can tell it's gone instead of releasing a ring that no longer exists
+    struct RingSet {
+        std::vector<Ring> rings;
+        explicit RingSet(int count) : rings(count) {}
+    };
+    struct ThreadRings;  // Per-thread list of claimed rings, released when the thread exits
+
+    uint64_t id;  // Never reused, unlike the bus's address
+    uint32_t capacityMask;
+    std::shared_ptr<RingSet> ringSet;
+    std::vector<std::vector<Handler>> handlers;  // Indexed by event type
+    std::atomic<uint64_t> unregisteredDrops{ 0 };  // From threads beyond maxThreads
+
+    Ring* threadRing();  // The calling thread's ring, or nullptr if all are taken
+};
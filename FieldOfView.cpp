@@ -0,0 +1,138 @@
+#include "FieldOfView.h"
+#include <algorithm>
+#include <cstdlib>
+
+// Integer division rounding toward negative infinity / positive infinity (denominator > 0)
+static int floorDiv(int numerator, int denominator) {
+    return numerator >= 0 ? numerator / denominator : -((-numerator + denominator - 1) / denominator);
+}
+static int ceilDiv(int numerator, int denominator) {
+    return -floorDiv(-numerator, denominator);
+}
+
+FieldOfView::FieldOfView(const Tilemap& tilemap, WorkerPool& workers) : tilemap(tilemap), workers(workers) {
+}
+
+int FieldOfView::addViewer(TilePoint position, int radius) {
+    int viewer;
+    if (!freeViewers.empty()) {
+        viewer = freeViewers.back();
+        freeViewers.pop_back();
+    }
+    else {
+        viewer = static_cast<int>(viewers.size());
+        viewers.emplace_back();
+    }
+    Viewer& v = viewers[viewer];
+    v.position = position;
+    v.radius = radius;
+    v.dirty = true;
+    v.changed = false;
+    v.alive = true;
+    v.visibility.bits.clear();
+    v.visibility.size = 0;  // Sees nothing until the next update()
+    return viewer;
+}
+
+void FieldOfView::removeViewer(int viewer) {
+    viewers[viewer].alive = false;
+    viewers[viewer].dirty = false;
+    freeViewers.push_back(viewer);
+}
+
+void FieldOfView::setViewerPosition(int viewer, TilePoint position) {
+    Viewer& v = viewers[viewer];
+    if (v.position == position) return;
+    v.position = position;
+    v.dirty = true;
+}
+
+void FieldOfView::update() {
+    // Only edits inside a viewer's square can change what it sees
+    for (const TilePoint& tile : tilemap.getChanges()) {
+        for (Viewer& viewer : viewers) {
+            if (viewer.alive && std::abs(tile.x - viewer.position.x) <= viewer.radius &&
+                std::abs(tile.y - viewer.position.y) <= viewer.radius) {
+                viewer.dirty = true;
+            }
+        }
+    }
+
+    dirtyViewers.clear();
+    for (size_t i = 0; i < viewers.size(); ++i) {
+        viewers[i].changed = viewers[i].dirty;
+        if (viewers[i].dirty) dirtyViewers.push_back(static_cast<int>(i));
+        viewers[i].dirty = false;
+    }
+    recomputed = static_cast<int>(dirtyViewers.size());
+
+    // Viewers only write their own bitset, so they can be computed side by side
+    const int jobs = std::min(recomputed, workers.getThreadCount() + 1);
+    workers.parallelFor(jobs, [&](int job) {
+        for (int i = job; i < recomputed; i += jobs) {
+            compute(viewers[dirtyViewers[i]]);
+        }
+    });
+}
+
+void FieldOfView::compute(Viewer& viewer) const {
+    VisibilityWindow& window = viewer.visibility;
+    window.originX = viewer.position.x - viewer.radius;
+    window.originY = viewer.position.y - viewer.radius;
+    window.size = viewer.radius * 2 + 1;
+    window.wordsPerRow = (window.size + 63) / 64;
+    window.bits.assign(static_cast<size_t>(window.size) * window.wordsPerRow, 0);
+
+    reveal(viewer, viewer.position.x, viewer.position.y);
+    for (int quadrant = 0; quadrant < 4; ++quadrant) {
+        scan(viewer, quadrant, 1, { -1, 1 }, { 1, 1 });
+    }
+}
+
+// One row of a quadrant at the given depth, between two slopes. Walls split the row
+// and the open parts continue one row further out.
+void FieldOfView::scan(Viewer& viewer, int quadrant, int depth, Slope start, Slope end) const {
+    if (depth > viewer.radius) return;
+
+    const int minCol = floorDiv(2 * depth * start.numerator + start.denominator, 2 * start.denominator);
+    const int maxCol = ceilDiv(2 * depth * end.numerator - end.denominator, 2 * end.denominator);
+    const int radiusSquared = viewer.radius * (viewer.radius + 1);  // Rounder edge than radius^2
+
+    int previous = -1;  // -1 none yet, 0 floor, 1 wall
+    for (int col = minCol; col <= maxCol; ++col) {
+        int x, y;
+        switch (quadrant) {
+        case 0: x = viewer.position.x + col; y = viewer.position.y - depth; break;  // North
+        case 1: x = viewer.position.x + depth; y = viewer.position.y + col; break;  // East
+        case 2: x = viewer.position.x + col; y = viewer.position.y + depth; break;  // South
+        default: x = viewer.position.x - depth; y = viewer.position.y + col; break; // West
+        }
+        const bool wall = isOpaque(x, y);
+
+        // Floors are only shown when their centre is inside the slopes, which makes sight symmetric
+        bool symmetric = col * start.denominator >= depth * start.numerator &&
+            col * end.denominator <= depth * end.numerator;
+        if ((wall || symmetric) && col * col + depth * depth <= radiusSquared && tilemap.inBounds(x, y)) {
+            reveal(viewer, x, y);
+        }
+
+        if (previous == 1 && !wall) {
+            start = { 2 * col - 1, 2 * depth };
+        }
+        if (previous == 0 && wall) {
+            scan(viewer, quadrant, depth + 1, start, { 2 * col - 1, 2 * depth });
+        }
+        previous = wall ? 1 : 0;
+    }
+    if (previous == 0) {
+        scan(viewer, quadrant, depth + 1, start, end);
+    }
+}
+
+void FieldOfView::reveal(Viewer& viewer, int x, int y) {
+    VisibilityWindow& window = viewer.visibility;
+    x -= window.originX;
+    y -= window.originY;
+    if (x < 0 || y < 0 || x >= window.size || y >= window.size) return;
+    window.bits[static_cast<size_t>(y) * window.wordsPerRow + (x >> 6)] |= 1ull << (x & 63);
+}
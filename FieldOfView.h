@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Tilemap.h"
+#include "WorkerPool.h"
+
+// Tiles one viewer can see, as a bitset over the square around it.
+// Rows start on a word boundary so they can be OR'd straight into larger bit planes.
+struct VisibilityWindow {
+    int originX = 0, originY = 0;  // Map tile of bit (0, 0)
+    int size = 0;                  // Tiles per side (2 * radius + 1)
+    int wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+
+    bool test(int x, int y) const {
+        x -= originX;
+        y -= originY;
+        if (x < 0 || y < 0 || x >= size || y >= size) return false;
+        return (bits[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+};
+
+// Line of sight for many viewers with symmetric shadowcasting (walls block sight): if A
+// sees B then B sees A, and every visible floor tile has an unobstructed line to it.
+// Each viewer caches its result and is only recomputed when it moves to another tile or
+// a tile within its radius changes, so canSee() is a bit test.
+class FieldOfView {
+public:
+    FieldOfView(const Tilemap& tilemap, WorkerPool& workers);
+
+    int addViewer(TilePoint position, int radius);
+    void removeViewer(int viewer);
+    void setViewerPosition(int viewer, TilePoint position);  // Cheap when the tile doesn't change
+
+    // Marks viewers near this frame's tile edits, then recomputes every dirty viewer on the workers
+    void update();
+
+    bool canSee(int viewer, int x, int y) const { return viewers[viewer].visibility.test(x, y); }
+    const VisibilityWindow& getVisibility(int viewer) const { return viewers[viewer].visibility; }
+    bool changedLastUpdate(int viewer) const { return viewers[viewer].changed; }
+
+    int getViewerCount() const { return static_cast<int>(viewers.size() - freeViewers.size()); }
+    int getRecomputedLastUpdate() const { return recomputed; }
+
+private:
+    struct Viewer {
+        TilePoint position;
+        int radius;
+        bool dirty;
+        bool changed;  // Recomputed in the last update()
+        bool alive;
+        VisibilityWindow visibility;
+    };
+
+    // Slopes are kept as exact fractions so the symmetry test never suffers rounding
+    struct Slope {
+        int numerator, denominator;
+    };
+
+    const Tilemap& tilemap;
+    WorkerPool& workers;
+    std::vector<Viewer> viewers;
+    std::vector<int> freeViewers;
+    std::vector<int> dirtyViewers;
+    int recomputed = 0;
+
+    bool isOpaque(int x, int y) const { return !tilemap.inBounds(x, y) || tilemap.getTile(x, y) == TILE_WALL; }
+    void compute(Viewer& viewer) const;
+    void scan(Viewer& viewer, int quadrant, int depth, Slope start, Slope end) const;
+    static void reveal(Viewer& viewer, int x, int y);
+};
@@ -0,0 +1,174 @@
+#include "FlowField.h"
+#include <algorithm>
+#include <functional>
+
+// Clockwise from east; the opposite of direction d is (d + 4) % 8 and odd ones are diagonal
+const int FlowField::DIRECTION_X[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+const int FlowField::DIRECTION_Y[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+static int moveCost(int direction) { return direction % 2 ? 14 : 10; }
+
+FlowFieldCache::FlowFieldCache(const Tilemap& tilemap, int capacity)
+    : tilemap(tilemap), capacity(capacity > 0 ? capacity : 1),
+      stamps(static_cast<size_t>(tilemap.getWidth()) * tilemap.getHeight(), 0) {
+    fields.reserve(this->capacity);  // Never reallocates, so handed-out fields don't move
+}
+
+// Same rule as the path finder: no cutting corners past walls
+bool FlowFieldCache::canMove(int x, int y, int direction) const {
+    int dx = FlowField::DIRECTION_X[direction], dy = FlowField::DIRECTION_Y[direction];
+    if (!tilemap.isWalkable(x + dx, y + dy)) return false;
+    return dx == 0 || dy == 0 || (tilemap.isWalkable(x + dx, y) && tilemap.isWalkable(x, y + dy));
+}
+
+const FlowField& FlowFieldCache::getField(TilePoint goal) {
+    for (FlowField& field : fields) {
+        if (field.goal == goal) {
+            field.lastUsed = frame;
+            return field;
+        }
+    }
+
+    FlowField* field;
+    if (static_cast<int>(fields.size()) < capacity) {
+        fields.emplace_back();
+        field = &fields.back();
+    }
+    else {
+        field = &*std::min_element(fields.begin(), fields.end(),
+                                   [](const FlowField& a, const FlowField& b) { return a.lastUsed < b.lastUsed; });
+    }
+    field->goal = goal;
+    field->lastUsed = frame;
+    build(*field);
+    built++;
+    return *field;
+}
+
+void FlowFieldCache::build(FlowField& field) {
+    const size_t tileCount = static_cast<size_t>(tilemap.getWidth()) * tilemap.getHeight();
+    field.width = tilemap.getWidth();
+    field.costs.assign(tileCount, FlowField::UNREACHABLE);
+    field.directions.assign(tileCount, FlowField::NO_DIRECTION);
+
+    open.clear();
+    if (tilemap.isWalkable(field.goal.x, field.goal.y)) {
+        int goal = field.goal.y * field.width + field.goal.x;
+        field.costs[goal] = 0;
+        open.push_back({ 0, goal });
+    }
+    propagate(field);
+}
+
+void FlowFieldCache::propagate(FlowField& field) {
+    const std::greater<std::pair<int, int>> later;
+    std::make_heap(open.begin(), open.end(), later);
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), later);
+        auto [cost, tile] = open.back();
+        open.pop_back();
+        if (cost > field.costs[tile]) continue;  // Stale entry
+
+        int x = tile % field.width, y = tile / field.width;
+        for (int direction = 0; direction < 8; ++direction) {
+            if (!canMove(x, y, direction)) continue;
+            int next = tile + FlowField::DIRECTION_Y[direction] * field.width + FlowField::DIRECTION_X[direction];
+            int nextCost = cost + moveCost(direction);
+            if (nextCost >= field.costs[next]) continue;
+            field.costs[next] = nextCost;
+            field.directions[next] = static_cast<uint8_t>((direction + 4) % 8);  // Back toward this tile
+            open.push_back({ nextCost, next });
+            std::push_heap(open.begin(), open.end(), later);
+        }
+    }
+}
+
+void FlowFieldCache::repair(FlowField& field) {
+    const int width = field.width;
+    for (const TilePoint& tile : tilemap.getChanges()) {
+        if (tile == field.goal) {
+            build(field);  // Everything depends on the goal
+            return;
+        }
+    }
+    if (++stamp == 0) {
+        std::fill(stamps.begin(), stamps.end(), 0);
+        stamp = 1;
+    }
+
+    // New walls: reset the tiles that stepped onto them or cut past their corners,
+    // then everything whose flow led through those tiles
+    reset.clear();
+    auto resetTile = [&](int index) {
+        if (stamps[index] == stamp || field.costs[index] == FlowField::UNREACHABLE) return;
+        stamps[index] = stamp;
+        reset.push_back(index);
+    };
+    for (const TilePoint& tile : tilemap.getChanges()) {
+        if (tilemap.isWalkable(tile.x, tile.y)) continue;
+        resetTile(tile.y * width + tile.x);
+        for (int direction = 0; direction < 8; ++direction) {
+            int nx = tile.x + FlowField::DIRECTION_X[direction], ny = tile.y + FlowField::DIRECTION_Y[direction];
+            if (!tilemap.inBounds(nx, ny)) continue;
+            int step = field.directions[ny * width + nx];
+            if (step == FlowField::NO_DIRECTION || step % 2 == 0) continue;
+            int dx = FlowField::DIRECTION_X[step], dy = FlowField::DIRECTION_Y[step];
+            if ((nx + dx == tile.x && ny == tile.y) || (nx == tile.x && ny + dy == tile.y)) {
+                resetTile(ny * width + nx);
+            }
+        }
+    }
+    for (size_t i = 0; i < reset.size(); ++i) {
+        int x = reset[i] % width, y = reset[i] / width;
+        for (int direction = 0; direction < 8; ++direction) {
+            int nx = x + FlowField::DIRECTION_X[direction], ny = y + FlowField::DIRECTION_Y[direction];
+            if (!tilemap.inBounds(nx, ny)) continue;
+            int step = field.directions[ny * width + nx];
+            if (step != FlowField::NO_DIRECTION && nx + FlowField::DIRECTION_X[step] == x &&
+                ny + FlowField::DIRECTION_Y[step] == y) {
+                resetTile(ny * width + nx);
+            }
+        }
+    }
+    for (int index : reset) {
+        field.costs[index] = FlowField::UNREACHABLE;
+        field.directions[index] = FlowField::NO_DIRECTION;
+    }
+    repaired += static_cast<int>(reset.size());
+
+    // Reset tiles pull their cost back in from the untouched tiles around them, and tiles
+    // around new openings push their costs outward; one Dijkstra settles both
+    open.clear();
+    for (int index : reset) {
+        int x = index % width, y = index / width;
+        for (int direction = 0; direction < 8; ++direction) {
+            int next = index + FlowField::DIRECTION_Y[direction] * width + FlowField::DIRECTION_X[direction];
+            if (canMove(x, y, direction) && field.costs[next] != FlowField::UNREACHABLE && stamps[next] != stamp) {
+                open.push_back({ field.costs[next], next });
+            }
+        }
+    }
+    for (const TilePoint& tile : tilemap.getChanges()) {
+        if (!tilemap.isWalkable(tile.x, tile.y)) continue;
+        for (int y = tile.y - 1; y <= tile.y + 1; ++y) {
+            for (int x = tile.x - 1; x <= tile.x + 1; ++x) {
+                if (tilemap.inBounds(x, y) && field.getCost(x, y) != FlowField::UNREACHABLE) {
+                    open.push_back({ field.getCost(x, y), y * width + x });
+                }
+            }
+        }
+    }
+    propagate(field);
+}
+
+void FlowFieldCache::update() {
+    builtLastFrame = built;
+    built = 0;
+    repaired = 0;
+    if (!tilemap.getChanges().empty()) {
+        for (FlowField& field : fields) {
+            repair(field);
+        }
+    }
+    frame++;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Tilemap.h"
+
+// Integration and direction fields toward one goal tile. Any agent on the map reads
+// its next step in O(1), so a crowd heading to the same goal shares one search.
+struct FlowField {
+    static constexpr int UNREACHABLE = INT32_MAX;
+    static constexpr uint8_t NO_DIRECTION = 8;
+
+    TilePoint goal;
+    int width;
+    std::vector<int> costs;           // Integration field: cost to reach the goal (10 straight, 14 diagonal)
+    std::vector<uint8_t> directions;  // Direction field: index into DIRECTION_X/Y, or NO_DIRECTION
+    uint32_t lastUsed = 0;
+
+    static const int DIRECTION_X[8];
+    static const int DIRECTION_Y[8];
+
+    int getCost(int x, int y) const { return costs[static_cast<size_t>(y) * width + x]; }
+
+    // Step toward the goal from a tile; false at the goal or where it can't be reached
+    bool getDirection(int x, int y, int& dx, int& dy) const {
+        uint8_t direction = directions[static_cast<size_t>(y) * width + x];
+        if (direction == NO_DIRECTION) return false;
+        dx = DIRECTION_X[direction];
+        dy = DIRECTION_Y[direction];
+        return true;
+    }
+};
+
+// Keeps flow fields for the goals in use, evicting the least recently used one when full.
+// Tile edits are repaired in place: a new wall only resets the tiles whose flow ran through
+// it, and a new opening only spreads the costs that got cheaper.
+class FlowFieldCache {
+public:
+    explicit FlowFieldCache(const Tilemap& tilemap, int capacity = 16);
+
+    // Returns the field for a goal, building it if needed. Fields never move in memory, but
+    // a full cache reuses the least recently used one for the new goal; fields looked up
+    // since the last update() go last, so up to capacity of them can be held at once.
+    const FlowField& getField(TilePoint goal);
+
+    // Repairs every cached field after this frame's tile edits, and ages the cache
+    void update();
+
+    int getFieldCount() const { return static_cast<int>(fields.size()); }
+    int getBuiltLastFrame() const { return builtLastFrame; }
+    int getRepairedLastFrame() const { return repaired; }  // Tiles whose cost was reset by edits
+
+private:
+    const Tilemap& tilemap;
+    int capacity;
+    uint32_t frame = 1;
+    std::vector<FlowField> fields;
+    int built = 0;  // Since the last update()
+    int builtLastFrame = 0;
+    int repaired = 0;
+
+    std::vector<std::pair<int, int>> open;  // (cost, tile) min-heap
+    std::vector<uint32_t> stamps;           // Marks reset tiles during a repair
+    uint32_t stamp = 0;
+    std::vector<int> reset;
+
+    bool canMove(int x, int y, int direction) const;
+    void build(FlowField& field);
+    void propagate(FlowField& field);  // Dijkstra from whatever is in the open list
+    void repair(FlowField& field);
+};
@@ -0,0 +1,115 @@
+#include "FogOfWar.h"
+#include <algorithm>
+#include <bit>
+
+FogOfWar::FogOfWar(int width, int height, int chunkSize)
+    : width(width), height(height), wordsPerRow((width + 63) / 64), chunkSize(chunkSize),
+      chunkColumns((width + chunkSize - 1) / chunkSize), chunkRows((height + chunkSize - 1) / chunkSize) {
+    visible.assign(static_cast<size_t>(wordsPerRow) * height, 0);
+    previousVisible = visible;
+    explored = visible;
+    chunkDirty.assign(static_cast<size_t>(chunkColumns) * chunkRows, 0);
+    clear();  // Every chunk starts dirty so the overlay gets filled
+}
+
+void FogOfWar::beginFrame() {
+    previousVisible.swap(visible);
+    std::fill(visible.begin(), visible.end(), 0);
+}
+
+void FogOfWar::reveal(const VisibilityWindow& visibility) {
+    for (int row = 0; row < visibility.size; ++row) {
+        int y = visibility.originY + row;
+        if (y < 0 || y >= height) continue;
+        const uint64_t* source = &visibility.bits[static_cast<size_t>(row) * visibility.wordsPerRow];
+        uint64_t* target = &visible[static_cast<size_t>(y) * wordsPerRow];
+
+        // Each window word lands on at most two map words
+        for (int i = 0; i < visibility.wordsPerRow; ++i) {
+            uint64_t bits = source[i];
+            int bit = visibility.originX + i * 64;
+            if (!bits || bit <= -64) continue;
+            if (bit < 0) {
+                bits >>= -bit;  // Drop the part left of the map
+                bit = 0;
+            }
+            int word = bit >> 6;
+            int shift = bit & 63;
+            if (word >= wordsPerRow) break;
+            target[word] |= bits << shift;
+            if (shift && word + 1 < wordsPerRow) target[word + 1] |= bits >> (64 - shift);
+        }
+    }
+}
+
+void FogOfWar::endFrame() {
+    // Windows can spill past the right edge into the padding bits of the last word
+    const uint64_t lastWordMask = width % 64 ? (uint64_t(1) << (width % 64)) - 1 : ~uint64_t(0);
+    const int chunksPerWord = 64 / chunkSize;
+    const uint64_t chunkMask = chunkSize == 64 ? ~uint64_t(0) : (uint64_t(1) << chunkSize) - 1;
+
+    // One pass: explored picks up what is visible, and fog only changed where visibility
+    // did (newly explored tiles are newly visible too), so that marks the dirty chunks
+    for (int y = 0; y < height; ++y) {
+        size_t rowStart = static_cast<size_t>(y) * wordsPerRow;
+        visible[rowStart + wordsPerRow - 1] &= lastWordMask;
+        for (int word = 0; word < wordsPerRow; ++word) {
+            uint64_t bits = visible[rowStart + word];
+            explored[rowStart + word] |= bits;
+            uint64_t changed = bits ^ previousVisible[rowStart + word];
+            for (int part = 0; changed; ++part) {
+                if (changed & chunkMask) markChunk((y / chunkSize) * chunkColumns + word * chunksPerWord + part);
+                changed = chunkSize == 64 ? 0 : changed >> chunkSize;
+            }
+        }
+    }
+}
+
+void FogOfWar::clear() {
+    std::fill(visible.begin(), visible.end(), 0);
+    std::fill(previousVisible.begin(), previousVisible.end(), 0);
+    std::fill(explored.begin(), explored.end(), 0);
+    for (int chunk = 0; chunk < chunkColumns * chunkRows; ++chunk) {
+        markChunk(chunk);
+    }
+}
+
+void FogOfWar::markChunk(int chunk) {
+    if (chunkDirty[chunk]) return;
+    chunkDirty[chunk] = 1;
+    dirtyChunks.push_back(chunk);
+}
+
+void FogOfWar::takeDirtyChunks(std::vector<int>& chunks) {
+    chunks.swap(dirtyChunks);
+    dirtyChunks.clear();
+    for (int chunk : chunks) {
+        chunkDirty[chunk] = 0;
+    }
+}
+
+uint32_t FogOfWar::getColour(int x, int y) const {
+    static const uint32_t colours[] = { 0xFF000000, 0xA0000000, 0x00000000 };  // Hidden, explored, visible
+    return colours[getState(x, y)];
+}
+
+int FogOfWar::countVisible() const {
+    int count = 0;
+    for (uint64_t word : visible) {
+        count += std::popcount(word);
+    }
+    return count;
+}
+
+int FogOfWar::countExplored() const {
+    int count = 0;
+    for (uint64_t word : explored) {
+        count += std::popcount(word);
+    }
+    return count;
+}
+
+size_t FogOfWar::getMemoryUsage() const {
+    return (visible.capacity() + previousVisible.capacity() + explored.capacity()) * sizeof(uint64_t) +
+        chunkDirty.capacity();
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "FieldOfView.h"
+
+enum FogState {
+    FOG_HIDDEN,    // Never seen
+    FOG_EXPLORED,  // Seen before, not right now
+    FOG_VISIBLE
+};
+
+// Per-tile fog of war as packed bit planes, one bit per tile and 64 tiles per word:
+// a 1024x1024 map takes 128 KB per plane. Each frame the visible plane is rebuilt by
+// OR'ing viewers' visibility rows into it a word at a time, explored picks up
+// everything visible, and chunks whose bits changed are flagged for the overlay.
+class FogOfWar {
+public:
+    FogOfWar(int width, int height, int chunkSize = 32);  // chunkSize must divide 64
+
+    void beginFrame();                                // Clears the visible plane
+    void reveal(const VisibilityWindow& visibility);  // Adds what one viewer sees
+    void endFrame();                                  // Updates explored and the dirty chunks
+
+    void clear();  // Forgets everything explored, like on entering a new level
+
+    bool isVisible(int x, int y) const { return testBit(visible, x, y); }
+    bool isExplored(int x, int y) const { return testBit(explored, x, y); }
+    FogState getState(int x, int y) const {
+        return isVisible(x, y) ? FOG_VISIBLE : isExplored(x, y) ? FOG_EXPLORED : FOG_HIDDEN;
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getChunkSize() const { return chunkSize; }
+    int getChunkColumns() const { return chunkColumns; }
+    int getChunkRows() const { return chunkRows; }
+
+    // Hands over the chunks (row-major indices) whose fog changed since the last call
+    void takeDirtyChunks(std::vector<int>& chunks);
+
+    // Overlay colour for a tile (0xAARRGGBB): black, dimmed when explored, clear when visible
+    uint32_t getColour(int x, int y) const;
+
+    int countVisible() const;
+    int countExplored() const;
+    size_t getMemoryUsage() const;
+
+private:
+    int width, height;
+    int wordsPerRow;
+    int chunkSize;
+    int chunkColumns, chunkRows;
+    std::vector<uint64_t> visible;
+    std::vector<uint64_t> previousVisible;
+    std::vector<uint64_t> explored;
+    std::vector<uint8_t> chunkDirty;
+    std::vector<int> dirtyChunks;
+
+    bool testBit(const std::vector<uint64_t>& plane, int x, int y) const {
+        if (x < 0 || y < 0 || x >= width || y >= height) return false;
+        return (plane[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+    void markChunk(int chunk);
+};
@@ -0,0 +1,173 @@
+#include "Lighting.h"
+#include <algorithm>
+
+LightMap::LightMap(const Tilemap& tilemap, int chunkSize)
+    : tilemap(tilemap), width(tilemap.getWidth()), height(tilemap.getHeight()), chunkSize(chunkSize),
+      chunkColumns((tilemap.getWidth() + chunkSize - 1) / chunkSize) {
+    size_t tileCount = static_cast<size_t>(width) * height;
+    levels.assign(tileCount, 0);
+    emission.assign(tileCount, 0);
+    firstLightOnTile.assign(tileCount, -1);
+    pendingFlags.assign(tileCount, 0);
+    int chunkCount = chunkColumns * ((height + chunkSize - 1) / chunkSize);
+    chunkDirty.assign(chunkCount, 1);  // Every chunk starts dirty so the overlay gets filled
+    for (int chunk = 0; chunk < chunkCount; ++chunk) {
+        dirtyChunks.push_back(chunk);
+    }
+}
+
+int LightMap::addLight(TilePoint position, int intensity) {
+    int light;
+    if (!freeLights.empty()) {
+        light = freeLights.back();
+        freeLights.pop_back();
+    }
+    else {
+        light = static_cast<int>(lights.size());
+        lights.emplace_back();
+    }
+    lights[light] = { position, std::clamp(intensity, 1, MAX_LEVEL), true, -1 };
+    linkLight(light);
+    markPending(position);
+    return light;
+}
+
+void LightMap::removeLight(int light) {
+    unlinkLight(light);
+    lights[light].alive = false;
+    markPending(lights[light].position);
+    freeLights.push_back(light);
+}
+
+void LightMap::setLightPosition(int light, TilePoint position) {
+    Light& moved = lights[light];
+    if (moved.position == position) return;
+    markPending(moved.position);
+    markPending(position);
+    unlinkLight(light);
+    moved.position = position;
+    linkLight(light);
+}
+
+void LightMap::update() {
+    for (const TilePoint& tile : tilemap.getChanges()) {
+        markPending(tile);
+    }
+
+    // Tiles that got darker (or became walls) are cleared and start the remove pass; every
+    // changed tile is re-seeded, along with its neighbours in case it just opened up
+    for (int tile : pendingTiles) {
+        pendingFlags[tile] = 0;
+        emission[tile] = isOpaque(tile) ? 0 : static_cast<uint8_t>(brightestLightAt(tile));
+        if (levels[tile] > 0 && (isOpaque(tile) || emission[tile] < levels[tile])) {
+            removeQueue.push_back({ tile, levels[tile] });
+            setLevel(tile, 0);
+        }
+        addQueue.push_back(tile);
+        int x = tile % width, y = tile / width;
+        if (x > 0) addQueue.push_back(tile - 1);
+        if (x < width - 1) addQueue.push_back(tile + 1);
+        if (y > 0) addQueue.push_back(tile - width);
+        if (y < height - 1) addQueue.push_back(tile + width);
+    }
+    pendingTiles.clear();
+
+    // Remove pass: a dimmer neighbour was lit through the cleared tile, so clear it too;
+    // a neighbour at least as bright has light from elsewhere and refills the gap later
+    for (size_t i = 0; i < removeQueue.size(); ++i) {
+        RemoveEntry entry = removeQueue[i];
+        if (emission[entry.tile] > 0) addQueue.push_back(entry.tile);
+        int x = entry.tile % width, y = entry.tile / width;
+        const int neighbours[4] = { x > 0 ? entry.tile - 1 : -1, x < width - 1 ? entry.tile + 1 : -1,
+                                    y > 0 ? entry.tile - width : -1, y < height - 1 ? entry.tile + width : -1 };
+        for (int neighbour : neighbours) {
+            if (neighbour < 0 || levels[neighbour] == 0) continue;
+            if (levels[neighbour] < entry.level) {
+                removeQueue.push_back({ neighbour, levels[neighbour] });
+                setLevel(neighbour, 0);
+            }
+            else {
+                addQueue.push_back(neighbour);
+            }
+        }
+    }
+
+    // Add pass: plain BFS flood fill, one level less per step
+    for (size_t i = 0; i < addQueue.size(); ++i) {
+        int tile = addQueue[i];
+        if (isOpaque(tile)) continue;
+        if (emission[tile] > levels[tile]) setLevel(tile, emission[tile]);
+        int level = levels[tile];
+        if (level <= 1) continue;
+        int x = tile % width, y = tile / width;
+        const int neighbours[4] = { x > 0 ? tile - 1 : -1, x < width - 1 ? tile + 1 : -1,
+                                    y > 0 ? tile - width : -1, y < height - 1 ? tile + width : -1 };
+        for (int neighbour : neighbours) {
+            if (neighbour < 0 || isOpaque(neighbour) || levels[neighbour] >= level - 1) continue;
+            setLevel(neighbour, level - 1);
+            addQueue.push_back(neighbour);
+        }
+    }
+
+    tilesTouched = static_cast<int>(removeQueue.size() + addQueue.size());
+    removeQueue.clear();
+    addQueue.clear();
+}
+
+uint32_t LightMap::getColour(int x, int y) const {
+    uint32_t alpha = (MAX_LEVEL - getLevel(x, y)) * 12;  // Up to 180, so unlit tiles stay readable
+    return alpha << 24 | 0x000010;                       // Slightly blue shadows
+}
+
+void LightMap::takeDirtyChunks(std::vector<int>& chunks) {
+    chunks.swap(dirtyChunks);
+    dirtyChunks.clear();
+    for (int chunk : chunks) {
+        chunkDirty[chunk] = 0;
+    }
+}
+
+void LightMap::markPending(TilePoint position) {
+    if (!tilemap.inBounds(position.x, position.y)) return;
+    int tile = position.y * width + position.x;
+    if (pendingFlags[tile]) return;
+    pendingFlags[tile] = 1;
+    pendingTiles.push_back(tile);
+}
+
+void LightMap::setLevel(int tile, int level) {
+    if (levels[tile] == level) return;
+    levels[tile] = static_cast<uint8_t>(level);
+    int chunk = (tile / width / chunkSize) * chunkColumns + (tile % width) / chunkSize;
+    if (!chunkDirty[chunk]) {
+        chunkDirty[chunk] = 1;
+        dirtyChunks.push_back(chunk);
+    }
+}
+
+void LightMap::linkLight(int light) {
+    const TilePoint& position = lights[light].position;
+    if (!tilemap.inBounds(position.x, position.y)) return;  // Lights no tile, so never looked up
+    int& first = firstLightOnTile[static_cast<size_t>(position.y) * width + position.x];
+    lights[light].nextOnTile = first;
+    first = light;
+}
+
+void LightMap::unlinkLight(int light) {
+    const TilePoint& position = lights[light].position;
+    if (!tilemap.inBounds(position.x, position.y)) return;
+    int* link = &firstLightOnTile[static_cast<size_t>(position.y) * width + position.x];
+    while (*link != light) {
+        link = &lights[*link].nextOnTile;
+    }
+    *link = lights[light].nextOnTile;
+}
+
+int LightMap::brightestLightAt(int tile) const {
+    // Only the lights on this tile, usually none or one
+    int brightest = 0;
+    for (int light = firstLightOnTile[tile]; light >= 0; light = lights[light].nextOnTile) {
+        brightest = std::max(brightest, lights[light].intensity);
+    }
+    return brightest;
+}
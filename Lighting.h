@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Tilemap.h"
+
+// Tile light levels from point lights (torches, lanterns). Light spreads from a light's
+// tile by flood fill, losing one level per step, and stops at walls; where lights
+// overlap the brightest one wins. Changes are applied incrementally in update(): tiles
+// that lost light are cleared by a remove queue that flows outwards until it meets light
+// from elsewhere, then an add queue fills everything back in from those borders and from
+// new or brighter lights. Only the area a change actually reaches is touched, so lights
+// can follow moving NPCs.
+class LightMap {
+public:
+    static constexpr int MAX_LEVEL = 15;
+
+    LightMap(const Tilemap& tilemap, int chunkSize = 16);
+
+    int addLight(TilePoint position, int intensity);  // Intensity 1..MAX_LEVEL, the level on the light's own tile
+    void removeLight(int light);
+    void setLightPosition(int light, TilePoint position);  // Cheap when the tile doesn't change
+
+    // Applies light changes and this frame's tile edits
+    void update();
+
+    int getLevel(int x, int y) const { return levels[static_cast<size_t>(y) * width + x]; }
+
+    // Overlay colour for a tile (0xAARRGGBB): dark, fading out as the level goes up
+    uint32_t getColour(int x, int y) const;
+
+    int getChunkSize() const { return chunkSize; }
+
+    // Hands over the chunks (row-major indices) whose levels changed since the last call
+    void takeDirtyChunks(std::vector<int>& chunks);
+
+    int getLightCount() const { return static_cast<int>(lights.size() - freeLights.size()); }
+    int getTilesTouchedLastUpdate() const { return tilesTouched; }
+
+private:
+    struct Light {
+        TilePoint position;
+        int intensity;
+        bool alive;
+        int nextOnTile;  // Next light on the same tile, or -1
+    };
+
+    struct RemoveEntry {
+        int tile;
+        uint8_t level;  // Level the tile had before it was cleared
+    };
+
+    const Tilemap& tilemap;
+    int width, height;
+    int chunkSize;
+    int chunkColumns;
+    std::vector<uint8_t> levels;
+    std::vector<uint8_t> emission;  // Brightest light on each tile
+    std::vector<Light> lights;
+    std::vector<int> freeLights;
+    std::vector<int> firstLightOnTile;  // Head of each tile's list of lights, or -1
+
+    std::vector<int> pendingTiles;         // Tiles whose light sources changed
+    std::vector<uint8_t> pendingFlags;
+    std::vector<RemoveEntry> removeQueue;
+    std::vector<int> addQueue;
+    std::vector<uint8_t> chunkDirty;
+    std::vector<int> dirtyChunks;
+    int tilesTouched = 0;
+
+    bool isOpaque(int tile) const { return tilemap.getTiles()[tile] == TILE_WALL; }
+    void markPending(TilePoint position);
+    void linkLight(int light);
+    void unlinkLight(int light);
+    void setLevel(int tile, int level);
+    int brightestLightAt(int tile) const;
+};
@@ -0,0 +1,139 @@
+#include "Palette.h"
+#include <SDL_image.h>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+// Packs a colour the way SDL_PIXELFORMAT_RGBA32 stores it in memory
+static Uint32 packRGBA32(const SDL_Color& color) {
+    Uint8 bytes[4] = { color.r, color.g, color.b, color.a };
+    Uint32 pixel;
+    std::memcpy(&pixel, bytes, sizeof(pixel));
+    return pixel;
+}
+
+bool loadIndexedImage(const std::string& path, IndexedImage& image) {
+    SDL_Surface* loaded = IMG_Load(path.c_str());
+    if (!loaded) {
+        std::cerr << "Failed to load image " << path << ": " << IMG_GetError() << std::endl;
+        return false;
+    }
+
+    image.width = loaded->w;
+    image.height = loaded->h;
+    image.indices.resize(static_cast<size_t>(image.width) * image.height);
+    image.palette.colors.clear();
+
+    // Paletted PNGs can be copied as they are
+    if (loaded->format->format == SDL_PIXELFORMAT_INDEX8 && loaded->format->palette) {
+        const SDL_Palette* source = loaded->format->palette;
+        image.palette.colors.assign(source->colors, source->colors + source->ncolors);
+        for (int y = 0; y < image.height; ++y) {
+            const Uint8* row = static_cast<const Uint8*>(loaded->pixels) + y * loaded->pitch;
+            std::memcpy(&image.indices[static_cast<size_t>(y) * image.width], row, image.width);
+        }
+        SDL_FreeSurface(loaded);
+        return true;
+    }
+
+    // Anything else is converted to RGBA and its colours collected into a palette
+    SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (!surface) {
+        std::cerr << "Failed to convert image " << path << ": " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    std::unordered_map<Uint32, Uint8> colorIndices;
+    bool fits = true;
+    for (int y = 0; y < image.height && fits; ++y) {
+        const Uint8* row = static_cast<const Uint8*>(surface->pixels) + y * surface->pitch;
+        for (int x = 0; x < image.width; ++x) {
+            const Uint8* p = row + x * 4;
+            SDL_Color color = { p[0], p[1], p[2], p[3] };
+            if (color.a == 0) color = { 0, 0, 0, 0 };  // All fully transparent pixels share one entry
+
+            Uint32 key = packRGBA32(color);
+            auto found = colorIndices.find(key);
+            if (found == colorIndices.end()) {
+                if (image.palette.colors.size() == 256) {
+                    fits = false;
+                    break;
+                }
+                found = colorIndices.emplace(key, static_cast<Uint8>(image.palette.colors.size())).first;
+                image.palette.colors.push_back(color);
+            }
+            image.indices[static_cast<size_t>(y) * image.width + x] = found->second;
+        }
+    }
+    SDL_FreeSurface(surface);
+
+    if (!fits) {
+        std::cerr << "Image " << path << " has more than 256 colours and cannot be palettized" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+SDL_Texture* createPaletteTexture(SDL_Renderer* renderer, const IndexedImage& image, const Palette& palette) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
+                                             image.width, image.height);
+    if (!texture) {
+        std::cerr << "Failed to create palette texture: " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    if (!applyPalette(texture, image, palette)) {
+        SDL_DestroyTexture(texture);
+        return nullptr;
+    }
+    return texture;
+}
+
+// Expands indices to RGBA32 rows through a 256-entry lookup table, a single load per pixel
+static void expandIndices(const IndexedImage& image, const Palette& palette, void* pixels, int pitch) {
+    Uint32 lookup[256] = {};
+    for (size_t i = 0; i < palette.colors.size() && i < 256; ++i) {
+        lookup[i] = packRGBA32(palette.colors[i]);
+    }
+    for (int y = 0; y < image.height; ++y) {
+        Uint32* row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(pixels) + y * pitch);
+        const Uint8* source = &image.indices[static_cast<size_t>(y) * image.width];
+        for (int x = 0; x < image.width; ++x) {
+            row[x] = lookup[source[x]];
+        }
+    }
+}
+
+SDL_Surface* createPaletteSurface(const IndexedImage& image, const Palette& palette) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, image.width, image.height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) {
+        std::cerr << "Failed to create palette surface: " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+    expandIndices(image, palette, surface->pixels, surface->pitch);
+    return surface;
+}
+
+bool applyPalette(SDL_Texture* texture, const IndexedImage& image, const Palette& palette) {
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) != 0) {
+        std::cerr << "Failed to lock palette texture: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    expandIndices(image, palette, pixels, pitch);
+    SDL_UnlockTexture(texture);
+    return true;
+}
+
+Palette flashPalette(const Palette& base, SDL_Color flash) {
+    Palette result = base;
+    for (SDL_Color& color : result.colors) {
+        if (color.a == 0) continue;  // Keep transparent pixels transparent
+        color.r = flash.r;
+        color.g = flash.g;
+        color.b = flash.b;
+    }
+    return result;
+}
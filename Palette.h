@@ -0,0 +1,33 @@
+#pragma once
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+// Up to 256 colours referenced by an indexed image
+struct Palette {
+    std::vector<SDL_Color> colors;
+};
+
+// 8-bit indexed image kept on the CPU (one byte per pixel instead of four).
+// Colour variants of the same image are just different palettes.
+struct IndexedImage {
+    int width = 0, height = 0;
+    std::vector<Uint8> indices;  // Row-major, width * height
+    Palette palette;             // Colours the image was loaded with
+};
+
+// Loads an image as 8-bit indices. Fails if the image uses more than 256 colours.
+bool loadIndexedImage(const std::string& path, IndexedImage& image);
+
+// Creates a texture showing the image through the given palette.
+// The texture is streaming so applyPalette() can swap its palette at runtime.
+SDL_Texture* createPaletteTexture(SDL_Renderer* renderer, const IndexedImage& image, const Palette& palette);
+
+// Expands the image through the given palette into a new RGBA surface (e.g. for packing into an atlas)
+SDL_Surface* createPaletteSurface(const IndexedImage& image, const Palette& palette);
+
+// Re-expands the image through another palette into an existing texture (e.g. damage flashes)
+bool applyPalette(SDL_Texture* texture, const IndexedImage& image, const Palette& palette);
+
+// Replaces every visible colour (hit flashes)
+Palette flashPalette(const Palette& base, SDL_Color flash);
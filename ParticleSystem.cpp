@@ -0,0 +1,194 @@
+#include "ParticleSystem.h"
+#include <algorithm>
+#include <cmath>
+
+ParticleSystem::ParticleSystem(WorkerPool& workers, int maxParticles, int particlesPerChunk)
+    : workers(workers), maxParticles(maxParticles), particlesPerChunk(particlesPerChunk) {
+    // Storage is allocated once for the cap, so spawning never reallocates
+    for (std::vector<float>* array : { &positionX, &positionY, &velocityX, &velocityY, &gravity, &age, &lifetime, &size }) {
+        array->resize(maxParticles);
+    }
+    colour.resize(maxParticles);
+}
+
+int ParticleSystem::addEmitter(const ParticleEffect& effect, float x, float y, float rate) {
+    int emitter;
+    if (!freeEmitters.empty()) {
+        emitter = freeEmitters.back();
+        freeEmitters.pop_back();
+    }
+    else {
+        emitter = static_cast<int>(emitters.size());
+        emitters.emplace_back();
+    }
+    emitters[emitter] = { effect, x, y, rate, 0.0f, true };
+    return emitter;
+}
+
+void ParticleSystem::removeEmitter(int emitter) {
+    emitters[emitter].alive = false;  // Its particles live out their lifetime
+    freeEmitters.push_back(emitter);
+}
+
+void ParticleSystem::setEmitterPosition(int emitter, float x, float y) {
+    emitters[emitter].x = x;
+    emitters[emitter].y = y;
+}
+
+void ParticleSystem::setEmitterRate(int emitter, float rate) {
+    emitters[emitter].rate = rate;
+}
+
+void ParticleSystem::burst(int emitter, int burstCount) {
+    spawn(emitters[emitter], burstCount);
+}
+
+void ParticleSystem::update(float deltaTime) {
+    for (Emitter& emitter : emitters) {
+        if (!emitter.alive || emitter.rate <= 0.0f) continue;
+        emitter.accumulator += emitter.rate * deltaTime;
+        int spawnCount = static_cast<int>(emitter.accumulator);
+        emitter.accumulator -= spawnCount;
+        spawn(emitter, spawnCount);
+    }
+
+    // Straight-line loops over separate arrays, no branches, so they vectorize
+    const int jobs = (count + particlesPerChunk - 1) / particlesPerChunk;
+    workers.parallelFor(jobs, [&](int job) {
+        const int begin = job * particlesPerChunk;
+        const int end = std::min(begin + particlesPerChunk, count);
+        float* x = positionX.data();
+        float* y = positionY.data();
+        const float* vx = velocityX.data();
+        float* vy = velocityY.data();
+        const float* g = gravity.data();
+        float* a = age.data();
+        for (int i = begin; i < end; ++i) {
+            vy[i] += g[i] * deltaTime;
+            x[i] += vx[i] * deltaTime;
+            y[i] += vy[i] * deltaTime;
+            a[i] += deltaTime;
+        }
+    });
+
+    removeDead();
+}
+
+void ParticleSystem::removeDead() {
+    // Swap-remove: the last live particle fills the hole, nothing else moves
+    for (int i = 0; i < count;) {
+        if (age[i] < lifetime[i]) {
+            ++i;
+            continue;
+        }
+        int last = --count;
+        positionX[i] = positionX[last];
+        positionY[i] = positionY[last];
+        velocityX[i] = velocityX[last];
+        velocityY[i] = velocityY[last];
+        gravity[i] = gravity[last];
+        age[i] = age[last];
+        lifetime[i] = lifetime[last];
+        size[i] = size[last];
+        colour[i] = colour[last];
+    }
+}
+
+void ParticleSystem::build(const Camera& camera) {
+    const int maxQuads = std::min(count, particlesPerChunk);
+    for (int quad = static_cast<int>(quadIndices.size()) / 6; quad < maxQuads; ++quad) {
+        int base = quad * 4;
+        int pattern[6] = { base, base + 1, base + 2, base + 2, base + 1, base + 3 };
+        quadIndices.insert(quadIndices.end(), pattern, pattern + 6);
+    }
+    activeChunks = (count + particlesPerChunk - 1) / particlesPerChunk;
+    if (static_cast<int>(chunks.size()) < activeChunks) chunks.resize(activeChunks);
+
+    const float halfWidth = camera.screenWidth * 0.5f, halfHeight = camera.screenHeight * 0.5f;
+    workers.parallelFor(activeChunks, [&](int chunkIndex) {
+        Chunk& chunk = chunks[chunkIndex];
+        const int begin = chunkIndex * particlesPerChunk;
+        const int end = std::min(begin + particlesPerChunk, count);
+        if (chunk.vertices.size() < static_cast<size_t>(end - begin) * 4) {
+            chunk.vertices.resize(static_cast<size_t>(end - begin) * 4);
+        }
+
+        int quads = 0;
+        for (int i = begin; i < end; ++i) {
+            float side = size[i] * camera.zoom;
+            float left = (positionX[i] - camera.x) * camera.zoom + halfWidth - side * 0.5f;
+            float top = (positionY[i] - camera.y) * camera.zoom + halfHeight - side * 0.5f;
+            if (left + side < 0.0f || top + side < 0.0f || left > camera.screenWidth || top > camera.screenHeight) continue;
+
+            uint32_t rgb = colour[i];
+            float fade = 1.0f - age[i] / lifetime[i];
+            SDL_Color tint = { static_cast<Uint8>(rgb), static_cast<Uint8>(rgb >> 8), static_cast<Uint8>(rgb >> 16),
+                               static_cast<Uint8>((rgb >> 24) * fade) };
+            SDL_Vertex* v = &chunk.vertices[static_cast<size_t>(quads) * 4];
+            v[0] = { { left, top }, tint, { 0.0f, 0.0f } };
+            v[1] = { { left + side, top }, tint, { 0.0f, 0.0f } };
+            v[2] = { { left, top + side }, tint, { 0.0f, 0.0f } };
+            v[3] = { { left + side, top + side }, tint, { 0.0f, 0.0f } };
+            ++quads;
+        }
+        chunk.quads = quads;
+    });
+}
+
+void ParticleSystem::submit(SDL_Renderer* renderer) {
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    for (int i = 0; i < activeChunks; ++i) {
+        const Chunk& chunk = chunks[i];
+        if (chunk.quads == 0) continue;
+        SDL_RenderGeometry(renderer, nullptr, chunk.vertices.data(), chunk.quads * 4,
+                           quadIndices.data(), chunk.quads * 6);
+    }
+}
+
+void ParticleSystem::getQuadBounds(std::vector<SDL_Rect>& bounds) const {
+    bounds.clear();
+    for (int i = 0; i < activeChunks; ++i) {
+        const Chunk& chunk = chunks[i];
+        for (int quad = 0; quad < chunk.quads; ++quad) {
+            const SDL_Vertex* v = &chunk.vertices[static_cast<size_t>(quad) * 4];
+            int left = static_cast<int>(std::floor(v[0].position.x)), top = static_cast<int>(std::floor(v[0].position.y));
+            bounds.push_back({ left, top, static_cast<int>(std::ceil(v[3].position.x)) - left,
+                               static_cast<int>(std::ceil(v[3].position.y)) - top });
+        }
+    }
+}
+
+int ParticleSystem::getQuadCount() const {
+    int total = 0;
+    for (int i = 0; i < activeChunks; ++i) {
+        total += chunks[i].quads;
+    }
+    return total;
+}
+
+float ParticleSystem::randomFloat(float min, float max) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return min + (max - min) * (random >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleSystem::spawn(const Emitter& emitter, int spawnCount) {
+    const ParticleEffect& effect = emitter.effect;
+    const uint32_t rgba = effect.colour.r | effect.colour.g << 8 | effect.colour.b << 16 |
+        static_cast<uint32_t>(effect.colour.a) << 24;
+    spawnCount = std::min(spawnCount, maxParticles - count);  // Over the cap, new particles are dropped
+    for (int n = 0; n < spawnCount; ++n, ++count) {
+        float angle = randomFloat(0.0f, 6.2831853f);
+        float speed = randomFloat(effect.minSpeed, effect.maxSpeed);
+        positionX[count] = emitter.x;
+        positionY[count] = emitter.y;
+        velocityX[count] = std::cos(angle) * speed;
+        velocityY[count] = std::sin(angle) * speed;
+        gravity[count] = effect.gravity;
+        age[count] = 0.0f;
+        lifetime[count] = randomFloat(effect.minLifetime, effect.maxLifetime);
+        size[count] = effect.size;
+        colour[count] = rgba;
+    }
+}
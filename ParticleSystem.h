@@ -0,0 +1,85 @@
+#pragma once
+#include <SDL.h>
+#include <cstdint>
+#include <vector>
+#include "Camera.h"
+#include "WorkerPool.h"
+
+// How particles from one emitter look and move
+struct ParticleEffect {
+    SDL_Color colour = { 255, 255, 255, 255 };
+    float minSpeed = 20.0f, maxSpeed = 60.0f;       // Pixels per second, in a random direction
+    float minLifetime = 0.5f, maxLifetime = 1.0f;   // Seconds; alpha fades to 0 over the lifetime
+    float size = 3.0f;                              // Quad side in world pixels
+    float gravity = 0.0f;                           // Downward acceleration, pixels per second squared
+};
+
+// Effects particles (dust, sparks, spell bursts), kept apart from gameplay sprites.
+// Particles are stored as structure-of-arrays and integrated in chunks on the workers
+// with branch-free loops the compiler can vectorize; dead particles are swap-removed,
+// so the live ones stay packed at the front. Emitters spawn at a steady rate, in
+// bursts, or both. Drawing builds untextured quads per chunk and submits them with
+// SDL_RenderGeometry, like SpriteBatch.
+class ParticleSystem {
+public:
+    explicit ParticleSystem(WorkerPool& workers, int maxParticles = 1 << 18, int particlesPerChunk = 8192);
+
+    int addEmitter(const ParticleEffect& effect, float x, float y, float rate = 0.0f);  // Rate in particles per second
+    void removeEmitter(int emitter);
+    void setEmitterPosition(int emitter, float x, float y);
+    void setEmitterRate(int emitter, float rate);
+    void burst(int emitter, int count);  // Spawns count particles right away
+
+    // Spawns from emitters, moves and ages particles, removes the dead ones
+    void update(float deltaTime);
+
+    // Fills vertices for particles on screen, then draws them on the render thread
+    void build(const Camera& camera);
+    void submit(SDL_Renderer* renderer);
+
+    // Screen rectangles of the quads from the last build, rounded outwards (for dirty-rect rendering)
+    void getQuadBounds(std::vector<SDL_Rect>& bounds) const;
+
+    int getParticleCount() const { return count; }
+    int getEmitterCount() const { return static_cast<int>(emitters.size() - freeEmitters.size()); }
+    int getQuadCount() const;
+
+private:
+    struct Emitter {
+        ParticleEffect effect;
+        float x, y;
+        float rate;
+        float accumulator;  // Fractional particles carried over between frames
+        bool alive;
+    };
+
+    struct Chunk {
+        std::vector<SDL_Vertex> vertices;  // Reused every frame, 4 per quad
+        int quads = 0;
+    };
+
+    WorkerPool& workers;
+    int maxParticles;
+    int particlesPerChunk;
+    int count = 0;
+
+    // One entry per particle in each array
+    std::vector<float> positionX, positionY;
+    std::vector<float> velocityX, velocityY;
+    std::vector<float> gravity;
+    std::vector<float> age, lifetime;
+    std::vector<float> size;
+    std::vector<uint32_t> colour;  // RGBA, one byte each from the low end; alpha fades with age when drawn
+
+    std::vector<Emitter> emitters;
+    std::vector<int> freeEmitters;
+    uint32_t random = 0x9E3779B9;
+
+    std::vector<Chunk> chunks;
+    std::vector<int> quadIndices;  // 0,1,2, 2,1,3 per quad, shared by all chunks
+    int activeChunks = 0;
+
+    float randomFloat(float min, float max);
+    void spawn(const Emitter& emitter, int spawnCount);
+    void removeDead();
+};
@@ -0,0 +1,422 @@
+#include "Pathfinding.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+static const int STRAIGHT_COST = 10;
+static const int DIAGONAL_COST = 14;
+
+// Lower bound on the cost between two tiles with 8-way movement
+static int octile(int ax, int ay, int bx, int by) {
+    int dx = std::abs(ax - bx);
+    int dy = std::abs(ay - by);
+    return STRAIGHT_COST * (dx + dy) + (DIAGONAL_COST - 2 * STRAIGHT_COST) * std::min(dx, dy);
+}
+
+PathFinder::PathFinder(const Tilemap& tilemap, WorkerPool& workers, int clusterSize, int cacheSize)
+    : tilemap(tilemap), workers(workers), clusterSize(clusterSize), cache(cacheSize > 0 ? cacheSize : 1) {
+    clustersX = (tilemap.getWidth() + clusterSize - 1) / clusterSize;
+    clustersY = (tilemap.getHeight() + clusterSize - 1) / clusterSize;
+    clusters.resize(static_cast<size_t>(clustersX) * clustersY);
+    clusterEditStamp.assign(clusters.size(), 0);
+    dirtyClusters.assign(clusters.size(), true);
+
+    size_t tileCount = static_cast<size_t>(tilemap.getWidth()) * tilemap.getHeight();
+    scratches.resize(workers.getThreadCount() + 1);
+    for (Scratch& scratch : scratches) {
+        scratch.tileStamp.assign(tileCount, 0);
+        scratch.tileCost.resize(tileCount);
+        scratch.tileParent.resize(tileCount);
+    }
+    rebuildGraph();
+}
+
+void PathFinder::clusterBounds(int cluster, int& minX, int& minY, int& maxX, int& maxY) const {
+    minX = (cluster % clustersX) * clusterSize;
+    minY = (cluster / clustersX) * clusterSize;
+    maxX = std::min(minX + clusterSize, tilemap.getWidth()) - 1;
+    maxY = std::min(minY + clusterSize, tilemap.getHeight()) - 1;
+}
+
+// Finds openings along the border between two neighbouring clusters. Each run of tiles
+// walkable on both sides gets an entrance in its middle, or one at each end if it is long.
+void PathFinder::addBorderEntrances(int clusterA, int clusterB, bool vertical,
+                                    std::vector<std::vector<TilePoint>>& entrances, std::vector<int>& links) const {
+    int minX, minY, maxX, maxY;
+    clusterBounds(clusterA, minX, minY, maxX, maxY);
+    int length = vertical ? maxY - minY + 1 : maxX - minX + 1;
+
+    auto tileA = [&](int i) { return vertical ? TilePoint{ maxX, minY + i } : TilePoint{ minX + i, maxY }; };
+    auto tileB = [&](int i) { return vertical ? TilePoint{ maxX + 1, minY + i } : TilePoint{ minX + i, maxY + 1 }; };
+    auto open = [&](int i) {
+        TilePoint a = tileA(i), b = tileB(i);
+        return tilemap.isWalkable(a.x, a.y) && tilemap.isWalkable(b.x, b.y);
+    };
+    auto addEntrance = [&](int i) {
+        links.push_back(clusterA);
+        links.push_back(static_cast<int>(entrances[clusterA].size()));
+        links.push_back(clusterB);
+        links.push_back(static_cast<int>(entrances[clusterB].size()));
+        entrances[clusterA].push_back(tileA(i));
+        entrances[clusterB].push_back(tileB(i));
+    };
+
+    for (int i = 0; i < length;) {
+        if (!open(i)) {
+            ++i;
+            continue;
+        }
+        int runStart = i;
+        while (i < length && open(i)) ++i;
+        int runEnd = i - 1;
+        if (runEnd - runStart + 1 < 6) {
+            addEntrance((runStart + runEnd) / 2);
+        }
+        else {
+            addEntrance(runStart);
+            addEntrance(runEnd);
+        }
+    }
+}
+
+void PathFinder::rebuildGraph() {
+    std::vector<std::vector<TilePoint>> entrances(clusters.size());
+    std::vector<int> links;  // clusterA, indexA, clusterB, indexB per border crossing
+    for (int cy = 0; cy < clustersY; ++cy) {
+        for (int cx = 0; cx < clustersX; ++cx) {
+            int cluster = cy * clustersX + cx;
+            if (cx + 1 < clustersX) addBorderEntrances(cluster, cluster + 1, true, entrances, links);
+            if (cy + 1 < clustersY) addBorderEntrances(cluster, cluster + clustersX, false, entrances, links);
+        }
+    }
+
+    // Only clusters whose tiles or entrances changed need their costs recomputed
+    std::vector<int> changed;
+    int nodeCount = 0;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Cluster& cluster = clusters[c];
+        if (dirtyClusters[c] || entrances[c].size() != cluster.entrances.size() ||
+            !std::equal(entrances[c].begin(), entrances[c].end(), cluster.entrances.begin())) {
+            cluster.entrances.swap(entrances[c]);
+            changed.push_back(static_cast<int>(c));
+        }
+        cluster.firstNode = nodeCount;
+        nodeCount += static_cast<int>(cluster.entrances.size());
+        dirtyClusters[c] = false;
+    }
+
+    nodes.resize(nodeCount);
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        for (size_t k = 0; k < clusters[c].entrances.size(); ++k) {
+            nodes[clusters[c].firstNode + k] = { clusters[c].entrances[k], static_cast<int>(c), -1 };
+        }
+    }
+    for (size_t i = 0; i < links.size(); i += 4) {
+        int a = clusters[links[i]].firstNode + links[i + 1];
+        int b = clusters[links[i + 2]].firstNode + links[i + 3];
+        nodes[a].partner = b;
+        nodes[b].partner = a;
+    }
+
+    for (Scratch& scratch : scratches) {
+        scratch.nodeStamp.assign(nodeCount + 1, 0);  // +1 for the goal of an abstract search
+        scratch.nodeCost.resize(nodeCount + 1);
+        scratch.nodeParent.resize(nodeCount + 1);
+    }
+
+    int jobs = std::min(static_cast<int>(changed.size()), static_cast<int>(scratches.size()));
+    workers.parallelFor(jobs, [&](int job) {
+        for (size_t i = job; i < changed.size(); i += jobs) {
+            computeClusterCosts(scratches[job], changed[i]);
+        }
+    });
+    graphDirty = false;
+}
+
+// Cost between every pair of entrances, one Dijkstra per entrance
+void PathFinder::computeClusterCosts(Scratch& scratch, int clusterIndex) {
+    Cluster& cluster = clusters[clusterIndex];
+    const int count = static_cast<int>(cluster.entrances.size());
+    const int width = tilemap.getWidth();
+    cluster.costs.assign(static_cast<size_t>(count) * count, -1);
+    for (int i = 0; i < count; ++i) {
+        searchTiles(scratch, cluster.entrances[i], -1, clusterIndex);
+        for (int j = 0; j < count; ++j) {
+            int index = cluster.entrances[j].y * width + cluster.entrances[j].x;
+            if (scratch.tileStamp[index] == scratch.generation) {
+                cluster.costs[static_cast<size_t>(i) * count + j] = scratch.tileCost[index];
+            }
+        }
+    }
+}
+
+int PathFinder::searchTiles(Scratch& scratch, TilePoint start, int goalIndex, int cluster) {
+    if (++scratch.generation == 0) {
+        std::fill(scratch.tileStamp.begin(), scratch.tileStamp.end(), 0);
+        std::fill(scratch.nodeStamp.begin(), scratch.nodeStamp.end(), 0);
+        scratch.generation = 1;
+    }
+    const uint32_t generation = scratch.generation;
+    const int width = tilemap.getWidth();
+    const int goalX = goalIndex >= 0 ? goalIndex % width : 0;
+    const int goalY = goalIndex >= 0 ? goalIndex / width : 0;
+    auto heuristic = [&](int x, int y) { return goalIndex >= 0 ? octile(x, y, goalX, goalY) : 0; };
+
+    int minX, minY, maxX, maxY;
+    clusterBounds(cluster, minX, minY, maxX, maxY);
+
+    int startIndex = start.y * width + start.x;
+    scratch.tileStamp[startIndex] = generation;
+    scratch.tileCost[startIndex] = 0;
+    scratch.tileParent[startIndex] = -1;
+    scratch.open.clear();
+    scratch.open.push_back({ heuristic(start.x, start.y), startIndex });
+
+    const std::greater<std::pair<int, int>> later;
+    while (!scratch.open.empty()) {
+        std::pop_heap(scratch.open.begin(), scratch.open.end(), later);
+        auto [f, index] = scratch.open.back();
+        scratch.open.pop_back();
+        int x = index % width, y = index / width;
+        int cost = scratch.tileCost[index];
+        if (f - heuristic(x, y) > cost) continue;  // Stale entry, a cheaper one was already expanded
+        if (index == goalIndex) return cost;
+
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dx == 0 && dy == 0) continue;
+                int nx = x + dx, ny = y + dy;
+                if (nx < minX || ny < minY || nx > maxX || ny > maxY || !tilemap.isWalkable(nx, ny)) continue;
+                if (dx != 0 && dy != 0 && (!tilemap.isWalkable(x + dx, y) || !tilemap.isWalkable(x, y + dy))) continue;
+
+                int next = ny * width + nx;
+                int nextCost = cost + (dx != 0 && dy != 0 ? DIAGONAL_COST : STRAIGHT_COST);
+                if (scratch.tileStamp[next] == generation && scratch.tileCost[next] <= nextCost) continue;
+                scratch.tileStamp[next] = generation;
+                scratch.tileCost[next] = nextCost;
+                scratch.tileParent[next] = index;
+                scratch.open.push_back({ nextCost + heuristic(nx, ny), next });
+                std::push_heap(scratch.open.begin(), scratch.open.end(), later);
+            }
+        }
+    }
+    return goalIndex >= 0 ? -1 : 0;
+}
+
+void PathFinder::appendTilePath(const Scratch& scratch, int goalIndex, std::vector<TilePoint>& path) const {
+    const int width = tilemap.getWidth();
+    size_t first = path.size();
+    for (int index = goalIndex; index >= 0; index = scratch.tileParent[index]) {
+        path.push_back({ index % width, index / width });
+    }
+    std::reverse(path.begin() + first, path.end());
+    if (first > 0 && path[first - 1] == path[first]) path.erase(path.begin() + first);  // Shared end point
+}
+
+bool PathFinder::search(Scratch& scratch, TilePoint start, TilePoint goal, std::vector<TilePoint>& path) {
+    path.clear();
+    if (!tilemap.isWalkable(start.x, start.y) || !tilemap.isWalkable(goal.x, goal.y)) return false;
+
+    const int width = tilemap.getWidth();
+    const int goalIndex = goal.y * width + goal.x;
+    const int startCluster = clusterOf(start);
+    const int goalCluster = clusterOf(goal);
+
+    // Short trips inside one cluster skip the abstract graph
+    if (startCluster == goalCluster && searchTiles(scratch, start, goalIndex, startCluster) >= 0) {
+        appendTilePath(scratch, goalIndex, path);
+        return true;
+    }
+
+    // Connect start and goal to the entrances of their clusters
+    const Cluster& first = clusters[startCluster];
+    const Cluster& last = clusters[goalCluster];
+    searchTiles(scratch, start, -1, startCluster);
+    scratch.startCosts.clear();
+    for (const TilePoint& entrance : first.entrances) {
+        int index = entrance.y * width + entrance.x;
+        scratch.startCosts.push_back(scratch.tileStamp[index] == scratch.generation ? scratch.tileCost[index] : -1);
+    }
+    searchTiles(scratch, goal, -1, goalCluster);  // Costs are symmetric, so goal -> entrance works
+    scratch.goalCosts.clear();
+    for (const TilePoint& entrance : last.entrances) {
+        int index = entrance.y * width + entrance.x;
+        scratch.goalCosts.push_back(scratch.tileStamp[index] == scratch.generation ? scratch.tileCost[index] : -1);
+    }
+
+    // A* over entrance nodes; node id nodes.size() stands for the goal
+    const int goalNode = static_cast<int>(nodes.size());
+    const uint32_t generation = scratch.generation;  // Node stamps only hold older generations
+    auto heuristic = [&](int node) {
+        return node == goalNode ? 0 : octile(nodes[node].tile.x, nodes[node].tile.y, goal.x, goal.y);
+    };
+    const std::greater<std::pair<int, int>> later;
+    scratch.open.clear();
+    auto relax = [&](int node, int cost, int parent) {
+        if (scratch.nodeStamp[node] == generation && scratch.nodeCost[node] <= cost) return;
+        scratch.nodeStamp[node] = generation;
+        scratch.nodeCost[node] = cost;
+        scratch.nodeParent[node] = parent;
+        scratch.open.push_back({ cost + heuristic(node), node });
+        std::push_heap(scratch.open.begin(), scratch.open.end(), later);
+    };
+    for (size_t k = 0; k < first.entrances.size(); ++k) {
+        if (scratch.startCosts[k] >= 0) relax(first.firstNode + static_cast<int>(k), scratch.startCosts[k], -1);
+    }
+
+    bool reached = false;
+    while (!scratch.open.empty()) {
+        std::pop_heap(scratch.open.begin(), scratch.open.end(), later);
+        auto [f, node] = scratch.open.back();
+        scratch.open.pop_back();
+        int cost = scratch.nodeCost[node];
+        if (f - heuristic(node) > cost) continue;
+        if (node == goalNode) {
+            reached = true;
+            break;
+        }
+
+        const Node& current = nodes[node];
+        const Cluster& cluster = clusters[current.cluster];
+        const int count = static_cast<int>(cluster.entrances.size());
+        const int k = node - cluster.firstNode;
+        if (current.cluster == goalCluster && scratch.goalCosts[k] >= 0) {
+            relax(goalNode, cost + scratch.goalCosts[k], node);
+        }
+        if (current.partner >= 0) relax(current.partner, cost + STRAIGHT_COST, node);
+        for (int j = 0; j < count; ++j) {
+            int edge = cluster.costs[static_cast<size_t>(k) * count + j];
+            if (j != k && edge >= 0) relax(cluster.firstNode + j, cost + edge, node);
+        }
+    }
+    if (!reached) return false;
+
+    scratch.hops.clear();
+    for (int node = scratch.nodeParent[goalNode]; node >= 0; node = scratch.nodeParent[node]) {
+        scratch.hops.push_back(node);
+    }
+    std::reverse(scratch.hops.begin(), scratch.hops.end());
+
+    // Refine each hop into tiles; crossing a border is a single step
+    TilePoint from = start;
+    int fromCluster = startCluster;
+    path.push_back(start);
+    for (size_t i = 0; i <= scratch.hops.size(); ++i) {
+        TilePoint to = i < scratch.hops.size() ? nodes[scratch.hops[i]].tile : goal;
+        int toCluster = i < scratch.hops.size() ? nodes[scratch.hops[i]].cluster : goalCluster;
+        if (toCluster != fromCluster) {
+            path.push_back(to);
+        }
+        else {
+            int toIndex = to.y * width + to.x;
+            if (searchTiles(scratch, from, toIndex, fromCluster) < 0) {
+                path.clear();
+                return false;  // Graph is out of date with the map
+            }
+            appendTilePath(scratch, toIndex, path);
+        }
+        from = to;
+        fromCluster = toCluster;
+    }
+    return true;
+}
+
+bool PathFinder::findPath(TilePoint start, TilePoint goal, std::vector<TilePoint>& path) {
+    return search(scratches[0], start, goal, path);
+}
+
+void PathFinder::requestPath(TilePoint start, TilePoint goal, int requester) {
+    pending.push_back({ start, goal, requester });
+}
+
+uint64_t PathFinder::makeKey(TilePoint start, TilePoint goal) const {
+    const uint64_t width = static_cast<uint64_t>(tilemap.getWidth());
+    return (start.y * width + start.x) << 32 | (goal.y * width + goal.x);
+}
+
+bool PathFinder::cacheLookup(uint64_t key, PathResult& result) const {
+    const CacheEntry& entry = cache[(key * 0x9E3779B97F4A7C15ull >> 32) % cache.size()];
+    if (entry.key != key) return false;
+    if (entry.found) {
+        for (int cluster : entry.clusters) {
+            if (clusterEditStamp[cluster] > entry.stamp) return false;
+        }
+    }
+    else if (editStamp > entry.stamp) {
+        return false;  // Any edit could have opened a way
+    }
+    result.found = entry.found;
+    result.path = entry.path;
+    return true;
+}
+
+void PathFinder::cacheStore(uint64_t key, const PathResult& result) {
+    CacheEntry& entry = cache[(key * 0x9E3779B97F4A7C15ull >> 32) % cache.size()];
+    entry.key = key;
+    entry.stamp = editStamp;
+    entry.found = result.found;
+    entry.path = result.path;
+    entry.clusters.clear();
+    for (const TilePoint& tile : result.path) {
+        int cluster = clusterOf(tile);
+        if (entry.clusters.empty() || entry.clusters.back() != cluster) entry.clusters.push_back(cluster);
+    }
+    std::sort(entry.clusters.begin(), entry.clusters.end());
+    entry.clusters.erase(std::unique(entry.clusters.begin(), entry.clusters.end()), entry.clusters.end());
+}
+
+void PathFinder::update(int maxSearches) {
+    results.clear();
+    cacheHits = 0;
+    searches = 0;
+
+    // Tile edits invalidate cached paths through their cluster and rebuild its part of the graph
+    if (!tilemap.getChanges().empty()) {
+        ++editStamp;
+        for (const TilePoint& tile : tilemap.getChanges()) {
+            int cluster = clusterOf(tile);
+            clusterEditStamp[cluster] = editStamp;
+            dirtyClusters[cluster] = true;
+        }
+        graphDirty = true;
+    }
+    if (graphDirty) rebuildGraph();
+
+    // Cache hits are answered right away and don't count against the budget
+    batch.clear();
+    size_t kept = 0;
+    for (const Request& request : pending) {
+        PathResult cached;
+        if (cacheLookup(makeKey(request.start, request.goal), cached)) {
+            cached.requester = request.requester;
+            results.push_back(std::move(cached));
+            cacheHits++;
+        }
+        else if (static_cast<int>(batch.size()) < maxSearches) {
+            batch.push_back(request);
+        }
+        else {
+            pending[kept++] = request;
+        }
+    }
+    pending.resize(kept);
+    if (batch.empty()) return;
+
+    // Each job owns one scratch and takes every jobs-th request
+    const size_t first = results.size();
+    const int count = static_cast<int>(batch.size());
+    results.resize(first + count);
+    const int jobs = std::min(count, static_cast<int>(scratches.size()));
+    workers.parallelFor(jobs, [&](int job) {
+        for (int i = job; i < count; i += jobs) {
+            PathResult& result = results[first + i];
+            result.requester = batch[i].requester;
+            result.found = search(scratches[job], batch[i].start, batch[i].goal, result.path);
+        }
+    });
+
+    for (int i = 0; i < count; ++i) {
+        cacheStore(makeKey(batch[i].start, batch[i].goal), results[first + i]);
+    }
+    searches = count;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Tilemap.h"
+#include "WorkerPool.h"
+
+struct PathResult {
+    int requester;                 // Value passed to requestPath()
+    bool found;
+    std::vector<TilePoint> path;   // Start to goal, both included
+};
+
+// Hierarchical A* (HPA*) over a tilemap. The map is cut into square clusters; walkable
+// openings between neighbouring clusters become entrance nodes, and the cost between
+// entrances of the same cluster is precomputed. Long queries search that small graph
+// first and then refine each hop with A* limited to a single cluster.
+//
+// Requests are queued and solved in batches on worker threads by update(), with a cap
+// on searches per frame; results of recent queries are cached until an edit touches
+// one of the clusters the path goes through. Movement is 8-way without cutting corners.
+class PathFinder {
+public:
+    PathFinder(const Tilemap& tilemap, WorkerPool& workers, int clusterSize = 16, int cacheSize = 1024);
+
+    // Solves one query right away on the calling thread
+    bool findPath(TilePoint start, TilePoint goal, std::vector<TilePoint>& path);
+
+    // Queues a query; its result shows up in getResults() after a later update()
+    void requestPath(TilePoint start, TilePoint goal, int requester);
+
+    // Picks up tile edits, then answers queued requests. Cache hits are always answered;
+    // at most maxSearches misses get searched and the rest wait, in order, for the next frame.
+    void update(int maxSearches);
+
+    const std::vector<PathResult>& getResults() const { return results; }
+    int getPendingCount() const { return static_cast<int>(pending.size()); }
+    int getCacheHitsLastUpdate() const { return cacheHits; }
+    int getSearchesLastUpdate() const { return searches; }
+    int getNodeCount() const { return static_cast<int>(nodes.size()); }
+
+private:
+    struct Cluster {
+        std::vector<TilePoint> entrances;  // In a fixed order, so unchanged clusters keep their costs
+        std::vector<int> costs;            // entrances x entrances, -1 if not connected inside the cluster
+        int firstNode = 0;                 // Node id of entrances[0]
+    };
+
+    struct Node {
+        TilePoint tile;
+        int cluster;
+        int partner;  // Entrance node on the other side of the border
+    };
+
+    // Per-thread search state; generation stamps avoid clearing the arrays between searches
+    struct Scratch {
+        std::vector<uint32_t> tileStamp;
+        std::vector<int> tileCost;
+        std::vector<int> tileParent;
+        std::vector<uint32_t> nodeStamp;
+        std::vector<int> nodeCost;
+        std::vector<int> nodeParent;
+        std::vector<std::pair<int, int>> open;  // (f, index) min-heap
+        std::vector<int> startCosts;            // Start -> each entrance of its cluster
+        std::vector<int> goalCosts;             // Each entrance of the goal cluster -> goal
+        std::vector<int> hops;
+        uint32_t generation = 0;
+    };
+
+    struct Request {
+        TilePoint start, goal;
+        int requester;
+    };
+
+    struct CacheEntry {
+        uint64_t key = UINT64_MAX;
+        uint32_t stamp = 0;           // Edit stamp when the path was found
+        bool found = false;
+        std::vector<TilePoint> path;
+        std::vector<int> clusters;    // Clusters the path passes through
+    };
+
+    const Tilemap& tilemap;
+    WorkerPool& workers;
+    int clusterSize;
+    int clustersX, clustersY;
+    std::vector<Cluster> clusters;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> clusterEditStamp;  // Last edit stamp per cluster
+    uint32_t editStamp = 0;
+    std::vector<bool> dirtyClusters;
+    bool graphDirty = true;
+
+    std::vector<Scratch> scratches;  // One per concurrent search
+    std::vector<CacheEntry> cache;   // Direct-mapped by start/goal
+    std::vector<Request> pending;
+    std::vector<Request> batch;
+    std::vector<PathResult> results;
+    int cacheHits = 0;
+    int searches = 0;
+
+    int clusterOf(TilePoint tile) const { return (tile.y / clusterSize) * clustersX + tile.x / clusterSize; }
+    void clusterBounds(int cluster, int& minX, int& minY, int& maxX, int& maxY) const;
+
+    void rebuildGraph();
+    void addBorderEntrances(int clusterA, int clusterB, bool vertical, std::vector<std::vector<TilePoint>>& entrances,
+                            std::vector<int>& links) const;
+    void computeClusterCosts(Scratch& scratch, int cluster);
+
+    // A* (or Dijkstra when goal is -1) limited to one cluster; returns the cost to goal or -1
+    int searchTiles(Scratch& scratch, TilePoint start, int goalIndex, int cluster);
+    void appendTilePath(const Scratch& scratch, int goalIndex, std::vector<TilePoint>& path) const;
+    bool search(Scratch& scratch, TilePoint start, TilePoint goal, std::vector<TilePoint>& path);
+
+    uint64_t makeKey(TilePoint start, TilePoint goal) const;
+    bool cacheLookup(uint64_t key, PathResult& result) const;
+    void cacheStore(uint64_t key, const PathResult& result);
+};
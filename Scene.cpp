@@ -0,0 +1,309 @@
+#include "Scene.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+// xorshift32, small and deterministic across platforms unlike rand()
+static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+bool simulateScene(SceneSnapshot& scene, const SceneRules& rules, double targetTime, double step,
+                   const std::atomic<bool>* stop) {
+    const int frames = static_cast<int>(step * 60.0 + 0.5);  // Agent speeds and lifetimes are per 60 Hz frame
+    int steps = 0;
+    while (scene.time + step <= targetTime) {
+        if (stop && (++steps & 63) == 0 && stop->load(std::memory_order_relaxed)) return false;
+
+        // Move and bounce like moveSprite(); expire in the same pass
+        size_t write = 0;
+        for (size_t read = 0; read < scene.agents.size(); ++read) {
+            SceneAgent agent = scene.agents[read];
+            agent.lifetime -= frames;
+            if (agent.lifetime <= 0) continue;
+
+            agent.x += agent.speedX * frames;
+            agent.y += agent.speedY * frames;
+            if (agent.x <= 0 || agent.x + rules.agentSize >= rules.width) agent.speedX = -agent.speedX;
+            if (agent.y <= 0 || agent.y + rules.agentSize >= rules.height) agent.speedY = -agent.speedY;
+            agent.x = std::clamp(agent.x, 0, rules.width - rules.agentSize);
+            agent.y = std::clamp(agent.y, 0, rules.height - rules.agentSize);
+            scene.agents[write++] = agent;
+        }
+        scene.agents.resize(write);
+
+        // Spawn like the live spawner, from the scene's own random state
+        scene.spawnAccumulator += step;
+        while (scene.spawnAccumulator >= rules.spawnInterval) {
+            scene.spawnAccumulator -= rules.spawnInterval;
+            uint32_t& r = scene.random;
+            SceneAgent agent;
+            agent.x = static_cast<int>(nextRandom(r) % (rules.width - rules.agentSize));
+            agent.y = static_cast<int>(nextRandom(r) % (rules.height - rules.agentSize));
+            agent.speedX = static_cast<int>(nextRandom(r) % 5 + 1) * (nextRandom(r) % 2 ? 1 : -1);
+            agent.speedY = static_cast<int>(nextRandom(r) % 5 + 1) * (nextRandom(r) % 2 ? 1 : -1);
+            agent.lifetime = rules.minLifetime + static_cast<int>(nextRandom(r) % (rules.maxLifetime - rules.minLifetime + 1));
+            agent.region = static_cast<int>(nextRandom(r) % rules.regionCount);
+            scene.agents.push_back(agent);
+        }
+        scene.time += step;
+    }
+    return true;
+}
+
+static const int TILE_CHUNK = 16;
+static const int AGENT_BLOCK = 64;
+
+static void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static uint32_t readVarint(const uint8_t*& in) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+}
+
+// Signed deltas as small unsigned numbers: 0, -1, 1, -2, ...
+static uint32_t zigzag(int value) { return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); }
+static int unzigzag(uint32_t value) { return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1); }
+
+size_t getSnapshotBytes(const SceneSnapshot& snapshot) {
+    return sizeof(SceneSnapshot) + snapshot.agents.capacity() * sizeof(SceneAgent) + snapshot.tiles.capacity();
+}
+
+void packScene(const SceneSnapshot& snapshot, PackedScene& packed) {
+    packed.tileColumns = snapshot.tileColumns;
+    packed.tileRows = snapshot.tileColumns > 0 ? static_cast<int>(snapshot.tiles.size()) / snapshot.tileColumns : 0;
+    packed.time = snapshot.time;
+    packed.spawnAccumulator = snapshot.spawnAccumulator;
+    packed.random = snapshot.random;
+    packed.unpackedBytes = getSnapshotBytes(snapshot);
+
+    // Tile chunks: palette size - 1, palette, then indices packed low bit first
+    packed.tileData.clear();
+    for (int chunkY = 0; chunkY < packed.tileRows; chunkY += TILE_CHUNK) {
+        for (int chunkX = 0; chunkX < packed.tileColumns; chunkX += TILE_CHUNK) {
+            const int endX = std::min(chunkX + TILE_CHUNK, packed.tileColumns);
+            const int endY = std::min(chunkY + TILE_CHUNK, packed.tileRows);
+            int remap[256];
+            std::fill(remap, remap + 256, -1);
+            uint8_t palette[256];
+            int paletteSize = 0;
+            for (int y = chunkY; y < endY; ++y) {
+                for (int x = chunkX; x < endX; ++x) {
+                    uint8_t tile = snapshot.tiles[static_cast<size_t>(y) * packed.tileColumns + x];
+                    if (remap[tile] < 0) {
+                        remap[tile] = paletteSize;
+                        palette[paletteSize++] = tile;
+                    }
+                }
+            }
+            packed.tileData.push_back(static_cast<uint8_t>(paletteSize - 1));
+            packed.tileData.insert(packed.tileData.end(), palette, palette + paletteSize);
+
+            int bits = 0;
+            while ((1 << bits) < paletteSize) ++bits;
+            uint32_t buffer = 0;
+            int buffered = 0;
+            for (int y = chunkY; y < endY && bits > 0; ++y) {
+                for (int x = chunkX; x < endX; ++x) {
+                    buffer |= static_cast<uint32_t>(remap[snapshot.tiles[static_cast<size_t>(y) * packed.tileColumns + x]]) << buffered;
+                    buffered += bits;
+                    while (buffered >= 8) {
+                        packed.tileData.push_back(static_cast<uint8_t>(buffer));
+                        buffer >>= 8;
+                        buffered -= 8;
+                    }
+                }
+            }
+            if (buffered > 0) packed.tileData.push_back(static_cast<uint8_t>(buffer));
+        }
+    }
+
+    // Agents sorted by row then column, so position deltas stay small
+    std::vector<SceneAgent> agents = snapshot.agents;
+    std::sort(agents.begin(), agents.end(), [](const SceneAgent& a, const SceneAgent& b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+    packed.agentCount = static_cast<int>(agents.size());
+    packed.agentData.clear();
+    for (size_t first = 0; first < agents.size(); first += AGENT_BLOCK) {
+        size_t last = std::min(first + AGENT_BLOCK, agents.size());
+        int previousX = 0, previousY = 0;  // Each block starts fresh so blocks decode on their own
+        for (size_t i = first; i < last; ++i) {
+            const SceneAgent& agent = agents[i];
+            int x = std::clamp(agent.x, 0, 0xFFFF), y = std::clamp(agent.y, 0, 0xFFFF);
+            writeVarint(packed.agentData, static_cast<uint32_t>(y - previousY));
+            writeVarint(packed.agentData, zigzag(x - previousX));
+            previousX = x;
+            previousY = y;
+            packed.agentData.push_back(static_cast<uint8_t>((std::clamp(agent.speedX, -8, 7) + 8) |
+                                                            (std::clamp(agent.speedY, -8, 7) + 8) << 4));
+            writeVarint(packed.agentData, static_cast<uint32_t>(std::clamp(agent.lifetime, 0, 0xFFFF)));
+            packed.agentData.push_back(static_cast<uint8_t>(std::clamp(agent.region, 0, 255)));
+        }
+    }
+    packed.tileData.shrink_to_fit();
+    packed.agentData.shrink_to_fit();
+}
+
+void unpackScene(const PackedScene& packed, SceneSnapshot& snapshot) {
+    snapshot.tileColumns = packed.tileColumns;
+    snapshot.time = packed.time;
+    snapshot.spawnAccumulator = packed.spawnAccumulator;
+    snapshot.random = packed.random;
+
+    snapshot.tiles.resize(static_cast<size_t>(packed.tileColumns) * packed.tileRows);
+    const uint8_t* in = packed.tileData.data();
+    for (int chunkY = 0; chunkY < packed.tileRows; chunkY += TILE_CHUNK) {
+        for (int chunkX = 0; chunkX < packed.tileColumns; chunkX += TILE_CHUNK) {
+            const int endX = std::min(chunkX + TILE_CHUNK, packed.tileColumns);
+            const int endY = std::min(chunkY + TILE_CHUNK, packed.tileRows);
+            int paletteSize = *in++ + 1;
+            const uint8_t* palette = in;
+            in += paletteSize;
+
+            int bits = 0;
+            while ((1 << bits) < paletteSize) ++bits;
+            if (bits == 0) {
+                for (int y = chunkY; y < endY; ++y) {
+                    uint8_t* row = &snapshot.tiles[static_cast<size_t>(y) * packed.tileColumns];
+                    std::fill(row + chunkX, row + endX, palette[0]);
+                }
+                continue;
+            }
+            const uint32_t mask = (1u << bits) - 1;
+            uint32_t buffer = 0;
+            int buffered = 0;
+            for (int y = chunkY; y < endY; ++y) {
+                uint8_t* row = &snapshot.tiles[static_cast<size_t>(y) * packed.tileColumns];
+                for (int x = chunkX; x < endX; ++x) {
+                    while (buffered < bits) {
+                        buffer |= static_cast<uint32_t>(*in++) << buffered;
+                        buffered += 8;
+                    }
+                    row[x] = palette[buffer & mask];
+                    buffer >>= bits;
+                    buffered -= bits;
+                }
+            }
+        }
+    }
+
+    snapshot.agents.resize(packed.agentCount);
+    in = packed.agentData.data();
+    int previousX = 0, previousY = 0;
+    for (int i = 0; i < packed.agentCount; ++i) {
+        if (i % AGENT_BLOCK == 0) previousX = previousY = 0;
+        SceneAgent& agent = snapshot.agents[i];
+        agent.y = previousY + static_cast<int>(readVarint(in));
+        agent.x = previousX + unzigzag(readVarint(in));
+        previousX = agent.x;
+        previousY = agent.y;
+        uint8_t speeds = *in++;
+        agent.speedX = (speeds & 0x0F) - 8;
+        agent.speedY = (speeds >> 4) - 8;
+        agent.lifetime = static_cast<int>(readVarint(in));
+        agent.region = *in++;
+    }
+}
+
+SceneManager::SceneManager(WorkerPool& workers, const SceneRules& rules, double step)
+    : workers(workers), rules(rules), step(step) {
+}
+
+SceneManager::~SceneManager() {
+    for (auto& scene : scenes) {
+        scene->stop = true;
+    }
+    for (auto& scene : scenes) {
+        while (scene->running) std::this_thread::yield();
+    }
+}
+
+int SceneManager::addScene(const std::string& name, SceneSnapshot snapshot) {
+    scenes.push_back(std::make_unique<SuspendedScene>());
+    SuspendedScene& scene = *scenes.back();
+    scene.name = name;
+    store(scene, snapshot);
+    return static_cast<int>(scenes.size()) - 1;
+}
+
+void SceneManager::store(SuspendedScene& scene, const SceneSnapshot& snapshot) {
+    packScene(snapshot, scene.packed);
+    scene.time = scene.packed.time;
+    scene.bytes = scene.packed.getBytes();
+    scene.unpackedBytes = scene.packed.unpackedBytes;
+}
+
+void SceneManager::suspend(int index, SceneSnapshot snapshot, double now) {
+    SuspendedScene& scene = *scenes[index];
+    std::lock_guard<std::mutex> lock(scene.mutex);
+    snapshot.time = now;
+    store(scene, snapshot);
+    scene.suspended = true;
+}
+
+SceneSnapshot SceneManager::resume(int index, double now) {
+    SuspendedScene& scene = *scenes[index];
+    scene.stop = true;  // A running job gives up within a few steps and keeps what it did
+    std::lock_guard<std::mutex> lock(scene.mutex);
+    scene.stop = false;
+
+    auto start = std::chrono::steady_clock::now();
+    SceneSnapshot live;
+    unpackScene(scene.packed, live);
+    simulateScene(live, rules, now, step);
+    live.time = now;  // Less than one step is dropped
+    lastResumeMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    scene.suspended = false;
+    scene.packed = PackedScene();
+    scene.bytes = 0;
+    scene.unpackedBytes = 0;
+    return live;
+}
+
+void SceneManager::catchUpInBackground(double now, double minLag) {
+    for (auto& owned : scenes) {
+        SuspendedScene* scene = owned.get();
+        if (!scene->suspended || scene->running || now - scene->time < std::max(minLag, step)) continue;
+        scene->running = true;
+        workers.enqueue([this, scene, now] {
+            {
+                std::lock_guard<std::mutex> lock(scene->mutex);
+                if (scene->suspended) {
+                    SceneSnapshot snapshot;
+                    unpackScene(scene->packed, snapshot);
+                    simulateScene(snapshot, rules, now, step, &scene->stop);
+                    store(*scene, snapshot);
+                }
+            }
+            scene->running = false;
+        });
+    }
+}
+
+double SceneManager::getLag(int index, double now) const {
+    const SuspendedScene& scene = *scenes[index];
+    return scene.suspended ? now - scene.time.load() : 0.0;
+}
+
+size_t SceneManager::getMemoryUsage(int index) const {
+    return scenes[index]->bytes;
+}
+
+size_t SceneManager::getUnpackedBytes(int index) const {
+    return scenes[index]->unpackedBytes;
+}
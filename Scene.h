@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "WorkerPool.h"
+
+// What a scene keeps of a sprite while it isn't live
+struct SceneAgent {
+    int x, y;
+    int speedX, speedY;
+    int lifetime;  // Frames left
+    int region;    // Atlas region
+};
+
+// Everything needed to carry on a scene without its live systems
+struct SceneSnapshot {
+    std::vector<SceneAgent> agents;
+    std::vector<uint8_t> tiles;
+    int tileColumns = 0;            // Tiles per row
+    double time = 0.0;              // Scene clock, in seconds
+    double spawnAccumulator = 0.0;  // Seconds toward the next spawn
+    uint32_t random = 1;            // The scene's own random state, so catch-up doesn't depend on who runs it
+};
+
+// Hibernated form of a snapshot, a fraction of its size:
+// - tiles in 16x16 chunks, each with its own palette and just enough bits per tile
+//   (0 bits for a chunk of one tile type)
+// - agents sorted by position in blocks of 64, with 16-bit positions stored as varint
+//   deltas, both speeds in one byte and varint lifetimes
+struct PackedScene {
+    std::vector<uint8_t> tileData;
+    std::vector<uint8_t> agentData;
+    int agentCount = 0;
+    int tileColumns = 0, tileRows = 0;
+    double time = 0.0;
+    double spawnAccumulator = 0.0;
+    uint32_t random = 1;
+    size_t unpackedBytes = 0;  // What the snapshot took before packing
+
+    size_t getBytes() const { return sizeof(PackedScene) + tileData.capacity() + agentData.capacity(); }
+};
+
+// Heap and struct bytes held by a snapshot
+size_t getSnapshotBytes(const SceneSnapshot& snapshot);
+
+// Positions must fit in 16 bits, speeds in -8..7, lifetimes and regions are clamped
+void packScene(const SceneSnapshot& snapshot, PackedScene& packed);
+void unpackScene(const PackedScene& packed, SceneSnapshot& snapshot);
+
+// How a scene behaves while suspended: a coarse version of the live game loop
+struct SceneRules {
+    int width, height;        // Bounds agents bounce off
+    int agentSize = 50;
+    float spawnInterval;      // Seconds between spawns
+    int regionCount;          // Atlas regions to pick from for new agents
+    int minLifetime, maxLifetime;  // Frames, inclusive; equal gives every agent the same lifetime
+};
+
+// Advances a suspended scene in fixed steps up to targetTime: agents move and bounce,
+// expire and spawn, but there are no collisions, triggers, scripts or rendering.
+// Steps are taken on a fixed grid from the scene clock, so the result only depends on the
+// target time, however the work is split up. Returns false if stop was raised first.
+bool simulateScene(SceneSnapshot& scene, const SceneRules& rules, double targetTime, double step,
+                   const std::atomic<bool>* stop = nullptr);
+
+// Keeps suspended scenes hibernated and fast-forwards them on worker threads while the
+// player is elsewhere, so resuming one only has to unpack it and simulate the last few steps.
+class SceneManager {
+public:
+    SceneManager(WorkerPool& workers, const SceneRules& rules, double step = 0.25);
+    ~SceneManager();  // Waits for background catch-up to stop
+
+    int addScene(const std::string& name, SceneSnapshot snapshot);  // Added suspended
+
+    // Hands a live scene's state over at time now
+    void suspend(int scene, SceneSnapshot snapshot, double now);
+
+    // Brings a scene up to now, stopping its background job, and returns its state to go live
+    SceneSnapshot resume(int scene, double now);
+
+    // Queues catch-up to now for suspended scenes at least minLag seconds behind.
+    // Each job unpacks the scene, simulates it and packs it again.
+    void catchUpInBackground(double now, double minLag = 5.0);
+
+    const std::string& getName(int scene) const { return scenes[scene]->name; }
+    int getSceneCount() const { return static_cast<int>(scenes.size()); }
+    bool isSuspended(int scene) const { return scenes[scene]->suspended; }
+    double getLag(int scene, double now) const;  // Seconds the scene is behind
+    size_t getMemoryUsage(int scene) const;        // Packed bytes while suspended
+    size_t getUnpackedBytes(int scene) const;      // What the same scene takes unpacked
+    double getLastResumeMicroseconds() const { return lastResumeMicroseconds; }
+
+private:
+    struct SuspendedScene {
+        std::string name;
+        PackedScene packed;
+        bool suspended = true;
+        std::mutex mutex;                  // Held while the scene is being simulated
+        std::atomic<bool> running{ false };
+        std::atomic<bool> stop{ false };
+        std::atomic<double> time{ 0.0 };   // Copy of packed.time readable without the lock
+        std::atomic<size_t> bytes{ 0 };
+        std::atomic<size_t> unpackedBytes{ 0 };
+    };
+
+    WorkerPool& workers;
+    SceneRules rules;
+    double step;
+    std::vector<std::unique_ptr<SuspendedScene>> scenes;
+    double lastResumeMicroseconds = 0.0;
+
+    static void store(SuspendedScene& scene, const SceneSnapshot& snapshot);  // Packs and updates the counters
+};
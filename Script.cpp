@@ -0,0 +1,183 @@
+#include "Script.h"
+#include <algorithm>
+#include <new>
+
+// Frames are rounded up to one of these sizes; bigger frames go to the regular heap
+static const size_t FRAME_SIZE_CLASSES[] = { 128, 256, 512, 1024, 2048, 4096 };
+static const int FRAME_CLASS_COUNT = sizeof(FRAME_SIZE_CLASSES) / sizeof(FRAME_SIZE_CLASSES[0]);
+static const int FRAMES_PER_BLOCK = 32;
+
+struct FrameFreeLists {
+    std::vector<void*> free[FRAME_CLASS_COUNT];
+    std::vector<void*> blocks;  // Backing memory, kept for the life of the program
+
+    ~FrameFreeLists() {
+        for (void* block : blocks) ::operator delete(block);
+    }
+};
+
+static FrameFreeLists& frameFreeLists() {
+    static FrameFreeLists lists;
+    return lists;
+}
+
+static int frameSizeClass(size_t size) {
+    for (int i = 0; i < FRAME_CLASS_COUNT; ++i) {
+        if (size <= FRAME_SIZE_CLASSES[i]) return i;
+    }
+    return -1;
+}
+
+void* ScriptFramePool::allocate(size_t size) {
+    int sizeClass = frameSizeClass(size);
+    if (sizeClass < 0) return ::operator new(size);
+
+    FrameFreeLists& lists = frameFreeLists();
+    std::vector<void*>& freeList = lists.free[sizeClass];
+    if (freeList.empty()) {
+        // Carve a new block into frames of this size
+        const size_t frameSize = FRAME_SIZE_CLASSES[sizeClass];
+        char* block = static_cast<char*>(::operator new(frameSize * FRAMES_PER_BLOCK));
+        lists.blocks.push_back(block);
+        for (int i = FRAMES_PER_BLOCK - 1; i >= 0; --i) {
+            freeList.push_back(block + frameSize * i);
+        }
+    }
+    void* memory = freeList.back();
+    freeList.pop_back();
+    return memory;
+}
+
+void ScriptFramePool::release(void* memory, size_t size) {
+    int sizeClass = frameSizeClass(size);
+    if (sizeClass < 0) {
+        ::operator delete(memory);
+        return;
+    }
+    frameFreeLists().free[sizeClass].push_back(memory);
+}
+
+ScriptScheduler::~ScriptScheduler() {
+    // Destroy every script that is still waiting on something
+    for (const FrameWait& wait : frameWaits) wait.handle.destroy();
+    for (const TimeWait& wait : timeWaits) wait.handle.destroy();
+    for (const EventWaits& waits : eventWaits) {
+        for (const EventWait& wait : waits.any) wait.handle.destroy();
+        for (const auto& subject : waits.bySubject) {
+            for (const EventWait& wait : subject.second) wait.handle.destroy();
+        }
+    }
+    for (const AnimationWaits& waits : animationWaits) {
+        for (const std::vector<std::coroutine_handle<>>& handles : waits.byAnimator) {
+            for (std::coroutine_handle<> handle : handles) handle.destroy();
+        }
+    }
+    for (std::coroutine_handle<> handle : ready) handle.destroy();
+}
+
+void ScriptScheduler::start(ScriptTask task) {
+    running++;
+    resume(task.handle);
+}
+
+void ScriptScheduler::listen(EventBus& bus) {
+    for (int type = 0; type < static_cast<int>(EngineEventType::Count); ++type) {
+        bus.subscribe(static_cast<EngineEventType>(type), [this](const EngineEvent& event) { onEvent(event); });
+    }
+}
+
+// Heap orderings: the earliest wake-up sits at the front
+bool ScriptScheduler::frameLater(const FrameWait& a, const FrameWait& b) {
+    return a.frame > b.frame;
+}
+
+bool ScriptScheduler::timeLater(const TimeWait& a, const TimeWait& b) {
+    return a.time > b.time;
+}
+
+void ScriptScheduler::resume(std::coroutine_handle<> handle) {
+    handle.resume();
+    if (handle.done()) {
+        handle.destroy();
+        running--;
+    }
+}
+
+void ScriptScheduler::FrameAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    scheduler.frameWaits.push_back({ wakeFrame, handle });
+    std::push_heap(scheduler.frameWaits.begin(), scheduler.frameWaits.end(), frameLater);
+}
+
+void ScriptScheduler::TimeAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    scheduler.timeWaits.push_back({ wakeTime, handle });
+    std::push_heap(scheduler.timeWaits.begin(), scheduler.timeWaits.end(), timeLater);
+}
+
+void ScriptScheduler::EventAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    EventWaits& waits = scheduler.eventWaits[static_cast<size_t>(type)];
+    (subject < 0 ? waits.any : waits.bySubject[subject]).push_back({ &result, handle });
+}
+
+void ScriptScheduler::AnimationAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    auto found = std::find_if(scheduler.animationWaits.begin(), scheduler.animationWaits.end(),
+                              [this](const AnimationWaits& waits) { return waits.animations == &animations; });
+    if (found == scheduler.animationWaits.end()) {
+        scheduler.animationWaits.push_back({ &animations, {} });
+        found = scheduler.animationWaits.end() - 1;
+    }
+    if (animator >= static_cast<int>(found->byAnimator.size())) found->byAnimator.resize(animator + 1);
+    found->byAnimator[animator].push_back(handle);
+}
+
+void ScriptScheduler::onEvent(const EngineEvent& event) {
+    // Only the waiters for any subject and for this event's subject are touched
+    EventWaits& waits = eventWaits[static_cast<size_t>(event.type)];
+    wakeEventWaits(waits.any, event);
+    auto subject = waits.bySubject.find(event.a);
+    if (subject != waits.bySubject.end()) {
+        wakeEventWaits(subject->second, event);
+        waits.bySubject.erase(subject);
+    }
+}
+
+void ScriptScheduler::wakeEventWaits(std::vector<EventWait>& waits, const EngineEvent& event) {
+    for (const EventWait& wait : waits) {
+        *wait.result = event;
+        ready.push_back(wait.handle);
+    }
+    waits.clear();
+}
+
+void ScriptScheduler::update(float deltaTime) {
+    frame++;
+    time += deltaTime;
+
+    // Pop only the waits that are due; the rest of each heap is untouched
+    while (!frameWaits.empty() && frameWaits.front().frame <= frame) {
+        std::pop_heap(frameWaits.begin(), frameWaits.end(), frameLater);
+        ready.push_back(frameWaits.back().handle);
+        frameWaits.pop_back();
+    }
+    while (!timeWaits.empty() && timeWaits.front().time <= time) {
+        std::pop_heap(timeWaits.begin(), timeWaits.end(), timeLater);
+        ready.push_back(timeWaits.back().handle);
+        timeWaits.pop_back();
+    }
+    // Only the animators that just finished are looked at, however many scripts wait
+    for (AnimationWaits& waits : animationWaits) {
+        for (int animator : waits.animations->getFinishedLastUpdate()) {
+            if (animator >= static_cast<int>(waits.byAnimator.size())) continue;
+            std::vector<std::coroutine_handle<>>& handles = waits.byAnimator[animator];
+            ready.insert(ready.end(), handles.begin(), handles.end());
+            handles.clear();
+        }
+    }
+
+    // Scripts resumed here may wait again; they land in the queues for a later update
+    resuming.swap(ready);
+    resumedLastUpdate = static_cast<int>(resuming.size());
+    for (std::coroutine_handle<> handle : resuming) {
+        resume(handle);
+    }
+    resuming.clear();
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <unordered_map>
+#include <vector>
+#include "Animation.h"
+#include "EventBus.h"
+
+class ScriptScheduler;
+
+// Allocator for script coroutine frames. Frames are carved from size-class free lists,
+// so starting and finishing scripts does not hit the general heap after warm-up.
+// Scripts run on the main thread only, so the pool is not thread-safe.
+class ScriptFramePool {
+public:
+    static void* allocate(size_t size);
+    static void release(void* memory, size_t size);
+};
+
+// Handle to a running script. Write scripts as coroutines returning ScriptTask:
+//
+//     ScriptTask greet(ScriptScheduler& scripts) {
+//         co_await scripts.seconds(2.0f);
+//         EngineEvent hit = co_await scripts.event(EngineEventType::TriggerEnter);
+//     }
+//
+// and hand them to ScriptScheduler::start(). The scheduler owns the coroutine from then on.
+struct ScriptTask {
+    struct promise_type {
+        ScriptTask get_return_object() { return ScriptTask{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+        std::suspend_always initial_suspend() noexcept { return {}; }  // Runs when the scheduler starts it
+        std::suspend_always final_suspend() noexcept { return {}; }    // Scheduler destroys finished scripts
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        static void* operator new(size_t size) { return ScriptFramePool::allocate(size); }
+        static void operator delete(void* memory, size_t size) { ScriptFramePool::release(memory, size); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Runs script coroutines. Waiting scripts sit in per-condition queues (frame and timer
+// heaps, event waits by type and subject, animation waits by animator), and only the
+// conditions that fired are looked up: due heap entries, the waiters of each published
+// event's subject, and the animators the AnimationSystem reports as finished. Thousands
+// of idle scripts cost nothing per frame.
+class ScriptScheduler {
+public:
+    ScriptScheduler() = default;
+    ~ScriptScheduler();
+
+    ScriptScheduler(const ScriptScheduler&) = delete;
+    ScriptScheduler& operator=(const ScriptScheduler&) = delete;
+
+    void start(ScriptTask task);  // Runs the script until its first wait
+    void listen(EventBus& bus);   // Lets scripts wait for events published on the bus
+    void update(float deltaTime); // Resumes scripts whose wait finished; animation ends come from the last AnimationSystem::update()
+
+    int getRunningCount() const { return running; }
+    int getResumedLastUpdate() const { return resumedLastUpdate; }
+
+    // Awaitables, used as `co_await scripts.frames(1)` inside a script
+    struct FrameAwaiter {
+        ScriptScheduler& scheduler;
+        uint64_t wakeFrame;
+        bool await_ready() const noexcept { return wakeFrame <= scheduler.frame; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept {}
+    };
+    struct TimeAwaiter {
+        ScriptScheduler& scheduler;
+        double wakeTime;
+        bool await_ready() const noexcept { return wakeTime <= scheduler.time; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept {}
+    };
+    struct EventAwaiter {
+        ScriptScheduler& scheduler;
+        EngineEventType type;
+        int subject;          // Only events whose a == subject, or -1 for any
+        EngineEvent result{};
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        EngineEvent await_resume() const noexcept { return result; }
+    };
+    struct AnimationAwaiter {
+        ScriptScheduler& scheduler;
+        const AnimationSystem& animations;
+        int animator;
+        bool await_ready() const noexcept { return animations.isFinished(animator); }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept {}
+    };
+
+    FrameAwaiter frames(int count) { return { *this, frame + static_cast<uint64_t>(count > 0 ? count : 0) }; }
+    TimeAwaiter seconds(float duration) { return { *this, time + duration }; }
+    EventAwaiter event(EngineEventType type, int subject = -1) { return { *this, type, subject }; }
+    AnimationAwaiter animationEnd(const AnimationSystem& animations, int animator) { return { *this, animations, animator }; }
+
+private:
+    struct FrameWait { uint64_t frame; std::coroutine_handle<> handle; };
+    struct TimeWait { double time; std::coroutine_handle<> handle; };
+    struct EventWait { EngineEvent* result; std::coroutine_handle<> handle; };
+    struct EventWaits {
+        std::vector<EventWait> any;                                 // Subject -1
+        std::unordered_map<int, std::vector<EventWait>> bySubject;  // Keyed by the event's a
+    };
+    struct AnimationWaits {
+        const AnimationSystem* animations;
+        std::vector<std::vector<std::coroutine_handle<>>> byAnimator;
+    };
+
+    uint64_t frame = 0;
+    double time = 0.0;
+    int running = 0;
+    int resumedLastUpdate = 0;
+
+    std::vector<FrameWait> frameWaits;  // Min-heaps on wake frame / wake time
+    std::vector<TimeWait> timeWaits;
+    std::vector<EventWaits> eventWaits = std::vector<EventWaits>(static_cast<size_t>(EngineEventType::Count));
+    std::vector<AnimationWaits> animationWaits;  // One entry per animation system scripts wait on
+    std::vector<std::coroutine_handle<>> ready;
+    std::vector<std::coroutine_handle<>> resuming;
+
+    static bool frameLater(const FrameWait& a, const FrameWait& b);
+    static bool timeLater(const TimeWait& a, const TimeWait& b);
+    void onEvent(const EngineEvent& event);
+    void wakeEventWaits(std::vector<EventWait>& waits, const EngineEvent& event);
+    void resume(std::coroutine_handle<> handle);
+};
@@ -0,0 +1,426 @@
+#include "ScriptVM.h"
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+
+// GCC and Clang dispatch through a table of label addresses; MSVC falls back to a switch
+#if defined(__GNUC__) || defined(__clang__)
+#define SCRIPT_VM_COMPUTED_GOTO 1
+#endif
+
+int ScriptVM::registerFunction(const std::string& name, NativeFunction function) {
+    auto found = functionIds.find(name);
+    if (found != functionIds.end()) {
+        functions[found->second] = std::move(function);
+        return found->second;
+    }
+    functions.push_back(std::move(function));
+    int id = static_cast<int>(functions.size()) - 1;
+    functionIds[name] = id;
+    return id;
+}
+
+int ScriptVM::findFunction(const std::string& name) const {
+    auto found = functionIds.find(name);
+    return found == functionIds.end() ? -1 : found->second;
+}
+
+int ScriptVM::intern(const std::string& text) {
+    auto found = stringIds.find(text);
+    if (found != stringIds.end()) return found->second;
+    strings.push_back(text);
+    flags.push_back(0);
+    int id = static_cast<int>(strings.size()) - 1;
+    stringIds[text] = id;
+    return id;
+}
+
+// Splits a line into tokens; quoted strings stay one token (quotes kept)
+static std::vector<std::string> tokenize(const std::string& line) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < line.size()) {
+        char ch = line[i];
+        if (ch == '#') break;
+        if (std::isspace(static_cast<unsigned char>(ch))) {
+            ++i;
+            continue;
+        }
+        size_t start = i;
+        if (ch == '"') {
+            ++i;
+            while (i < line.size() && line[i] != '"') ++i;
+            ++i;  // Closing quote
+        }
+        else {
+            while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i])) && line[i] != '#') ++i;
+        }
+        tokens.push_back(line.substr(start, i - start));
+    }
+    return tokens;
+}
+
+static bool isNumber(const std::string& token) {
+    size_t start = (token[0] == '-' && token.size() > 1) ? 1 : 0;
+    for (size_t i = start; i < token.size(); ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(token[i]))) return false;
+    }
+    return true;
+}
+
+static bool isIdentifier(const std::string& token) {
+    if (token.empty() || !(std::isalpha(static_cast<unsigned char>(token[0])) || token[0] == '_')) return false;
+    for (char ch : token) {
+        if (!(std::isalnum(static_cast<unsigned char>(ch)) || ch == '_')) return false;
+    }
+    return true;
+}
+
+static ScriptOp binaryOp(const std::string& token) {
+    if (token == "+") return ScriptOp::Add;
+    if (token == "-") return ScriptOp::Sub;
+    if (token == "*") return ScriptOp::Mul;
+    if (token == "/") return ScriptOp::Div;
+    if (token == "%") return ScriptOp::Mod;
+    if (token == "<") return ScriptOp::Less;
+    if (token == "<=") return ScriptOp::LessEqual;
+    if (token == ">") return ScriptOp::Greater;
+    if (token == ">=") return ScriptOp::GreaterEqual;
+    if (token == "==") return ScriptOp::Equal;
+    if (token == "!=") return ScriptOp::NotEqual;
+    return ScriptOp::Count;
+}
+
+// Single-pass compiler state for one script
+struct ScriptCompiler {
+    ScriptVM& vm;
+    ScriptProgram& program;
+    std::unordered_map<std::string, int> variables;  // Name -> register
+    std::unordered_map<std::string, int> labels;     // Name -> instruction index
+    struct Fixup { size_t instruction; std::string label; int line; };
+    std::vector<Fixup> fixups;
+    int nextTemp = ScriptVM::VARIABLE_COUNT;
+    std::string error;
+
+    ScriptCompiler(ScriptVM& vm, ScriptProgram& program) : vm(vm), program(program) {}
+
+    void emit(ScriptOp op, int a = 0, int b = 0, int c = 0, int imm = 0) {
+        program.code.push_back({ op, static_cast<uint8_t>(a), static_cast<uint8_t>(b), static_cast<uint8_t>(c), imm });
+    }
+
+    int temp() {
+        if (nextTemp >= ScriptVM::REGISTER_COUNT) {
+            error = "expression too complex";
+            return -1;
+        }
+        return nextTemp++;
+    }
+
+    int variable(const std::string& name, bool create) {
+        auto found = variables.find(name);
+        if (found != variables.end()) return found->second;
+        if (!create) {
+            error = "unknown variable '" + name + "'";
+            return -1;
+        }
+        if (static_cast<int>(variables.size()) >= ScriptVM::VARIABLE_COUNT) {
+            error = "too many variables";
+            return -1;
+        }
+        int reg = static_cast<int>(variables.size());
+        variables[name] = reg;
+        return reg;
+    }
+
+    // Returns the register holding an operand, loading constants into a temporary
+    int operand(const std::string& token) {
+        if (isNumber(token)) {
+            errno = 0;
+            long value = std::strtol(token.c_str(), nullptr, 10);
+            if (errno == ERANGE || value < INT_MIN || value > INT_MAX) {
+                error = "constant '" + token + "' does not fit in an int";
+                return -1;
+            }
+            int reg = temp();
+            if (reg >= 0) emit(ScriptOp::LoadConst, reg, 0, 0, static_cast<int>(value));
+            return reg;
+        }
+        if (token.size() >= 2 && token.front() == '"' && token.back() == '"') {
+            int reg = temp();
+            if (reg >= 0) emit(ScriptOp::LoadConst, reg, 0, 0, vm.intern(token.substr(1, token.size() - 2)));
+            return reg;
+        }
+        if (isIdentifier(token)) return variable(token, false);
+        error = "bad operand '" + token + "'";
+        return -1;
+    }
+
+    static bool isString(const std::string& token) {
+        return token.size() >= 2 && token.front() == '"' && token.back() == '"';
+    }
+
+    // Compiles tokens[first..] as a value into register dest
+    bool expression(const std::vector<std::string>& tokens, size_t first, int dest) {
+        size_t count = tokens.size() - first;
+        if (count == 0) {
+            error = "missing value";
+            return false;
+        }
+        const std::string& head = tokens[first];
+
+        if (head == "flag") {
+            if (count != 2 || !isString(tokens[first + 1])) {
+                error = "flag needs a quoted name";
+                return false;
+            }
+            emit(ScriptOp::GetFlag, dest, 0, 0, vm.intern(tokens[first + 1].substr(1, tokens[first + 1].size() - 2)));
+            return true;
+        }
+        if (vm.findFunction(head) >= 0) return call(tokens, first, dest);
+
+        if (count == 1) {
+            int reg = operand(head);
+            if (reg < 0) return false;
+            if (reg != dest) emit(ScriptOp::Move, dest, reg);
+            return true;
+        }
+        if (count == 3) {
+            ScriptOp op = binaryOp(tokens[first + 1]);
+            if (op == ScriptOp::Count) {
+                error = "unknown operator '" + tokens[first + 1] + "'";
+                return false;
+            }
+            int left = operand(head);
+            int right = left >= 0 ? operand(tokens[first + 2]) : -1;
+            if (right < 0) return false;
+            emit(op, dest, left, right);
+            return true;
+        }
+        error = "cannot parse expression";
+        return false;
+    }
+
+    // Engine call: arguments are copied into consecutive temporaries
+    bool call(const std::vector<std::string>& tokens, size_t first, int dest) {
+        int function = vm.findFunction(tokens[first]);
+        int argCount = static_cast<int>(tokens.size() - first - 1);
+        if (argCount > ScriptVM::MAX_CALL_ARGS) {
+            error = "too many arguments";
+            return false;
+        }
+        int base = nextTemp;
+        for (int i = 0; i < argCount; ++i) {
+            if (temp() < 0) return false;
+        }
+        for (int i = 0; i < argCount; ++i) {
+            int saved = nextTemp;
+            int reg = operand(tokens[first + 1 + i]);
+            if (reg < 0) return false;
+            if (reg != base + i) emit(ScriptOp::Move, base + i, reg);
+            nextTemp = saved;  // Constants only live until they are copied
+        }
+        emit(ScriptOp::Call, dest, base, argCount, function);
+        return true;
+    }
+
+    bool jumpTo(ScriptOp op, int reg, const std::string& label, int line) {
+        if (!isIdentifier(label)) {
+            error = "bad label '" + label + "'";
+            return false;
+        }
+        fixups.push_back({ program.code.size(), label, line });
+        emit(op, reg);
+        return true;
+    }
+
+    bool statement(const std::vector<std::string>& tokens, int line) {
+        nextTemp = ScriptVM::VARIABLE_COUNT;
+        const std::string& head = tokens[0];
+
+        if (tokens.size() == 1 && head.size() > 1 && head.back() == ':') {
+            std::string name = head.substr(0, head.size() - 1);
+            if (!isIdentifier(name) || labels.count(name)) {
+                error = "bad or duplicate label '" + name + "'";
+                return false;
+            }
+            labels[name] = static_cast<int>(program.code.size());
+            return true;
+        }
+        if (head == "end" && tokens.size() == 1) {
+            emit(ScriptOp::End);
+            return true;
+        }
+        if (head == "param" && tokens.size() == 2 && isIdentifier(tokens[1])) {
+            if (variables.count(tokens[1]) || program.paramCount != static_cast<int>(variables.size())) {
+                error = "params must come first and be unique";
+                return false;
+            }
+            program.paramCount++;
+            return variable(tokens[1], true) >= 0;
+        }
+        if (head == "goto" && tokens.size() == 2) {
+            return jumpTo(ScriptOp::Jump, 0, tokens[1], line);
+        }
+        if (head == "if" && tokens.size() >= 4 && tokens[tokens.size() - 2] == "goto") {
+            // Condition is everything between `if` and `goto`
+            std::vector<std::string> condition(tokens.begin() + 1, tokens.end() - 2);
+            int reg = temp();
+            if (reg < 0 || !expression(condition, 0, reg)) return false;
+            return jumpTo(ScriptOp::JumpIfNotZero, reg, tokens.back(), line);
+        }
+        if (head == "setflag" && tokens.size() == 3 && isString(tokens[1])) {
+            int reg = operand(tokens[2]);
+            if (reg < 0) return false;
+            emit(ScriptOp::SetFlag, reg, 0, 0, vm.intern(tokens[1].substr(1, tokens[1].size() - 2)));
+            return true;
+        }
+        if (head == "let" && tokens.size() >= 4 && tokens[2] == "=" && isIdentifier(tokens[1])) {
+            int reg = variable(tokens[1], true);
+            return reg >= 0 && expression(tokens, 3, reg);
+        }
+        if (tokens.size() >= 3 && tokens[1] == "=" && isIdentifier(head)) {
+            int reg = variable(head, false);
+            return reg >= 0 && expression(tokens, 2, reg);
+        }
+        if (vm.findFunction(head) >= 0) {
+            int reg = temp();
+            return reg >= 0 && call(tokens, 0, reg);
+        }
+        error = "unknown statement '" + head + "'";
+        return false;
+    }
+};
+
+bool ScriptVM::compile(const std::string& source, ScriptProgram& program, std::string& error) {
+    program.code.clear();
+    program.paramCount = 0;
+    ScriptCompiler compiler(*this, program);
+
+    std::istringstream lines(source);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line)) {
+        ++lineNumber;
+        std::vector<std::string> tokens = tokenize(line);
+        if (tokens.empty()) continue;
+        if (!compiler.statement(tokens, lineNumber)) {
+            error = "line " + std::to_string(lineNumber) + ": " + compiler.error;
+            program.code.clear();  // Half-compiled code has no End, so it must never run
+            return false;
+        }
+    }
+    compiler.emit(ScriptOp::End);  // Falling off the end finishes the script
+
+    for (const ScriptCompiler::Fixup& fixup : compiler.fixups) {
+        auto found = compiler.labels.find(fixup.label);
+        if (found == compiler.labels.end()) {
+            error = "line " + std::to_string(fixup.line) + ": unknown label '" + fixup.label + "'";
+            program.code.clear();
+            return false;
+        }
+        program.code[fixup.instruction].imm = found->second;
+    }
+    return true;
+}
+
+// Script arithmetic wraps like two's complement instead of overflowing, and dividing by
+// zero gives 0, so no bytecode can hit undefined behaviour or trap (INT_MIN / -1 raises SIGFPE on x86)
+static int wrapAdd(int a, int b) { return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b)); }
+static int wrapSub(int a, int b) { return static_cast<int>(static_cast<unsigned>(a) - static_cast<unsigned>(b)); }
+static int wrapMul(int a, int b) { return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b)); }
+static int safeDiv(int a, int b) {
+    if (b == 0) return 0;
+    if (b == -1) return wrapSub(0, a);  // INT_MIN / -1 wraps to INT_MIN
+    return a / b;
+}
+static int safeMod(int a, int b) {
+    if (b == 0 || b == -1) return 0;  // Anything % -1 is 0, INT_MIN included
+    return a % b;
+}
+
+bool ScriptVM::run(const ScriptProgram& program, const int* args, int argCount, int maxInstructions) {
+    if (program.code.empty()) {  // Never compiled, or compiling failed
+        lastInstructionCount = 0;
+        return false;
+    }
+    int r[REGISTER_COUNT] = {};
+    for (int i = 0; i < argCount && i < program.paramCount; ++i) {
+        r[i] = args[i];
+    }
+
+    const ScriptInstruction* code = program.code.data();
+    const ScriptInstruction* ip = code;
+    // Instructions are counted per straight-line block when a jump is taken,
+    // so the budget check costs nothing between branches
+    const ScriptInstruction* blockStart = code;
+    int executed = 0;
+    bool finished = true;
+
+#ifdef SCRIPT_VM_COMPUTED_GOTO
+    static void* const labels[] = {
+        &&op_LoadConst, &&op_Move,
+        &&op_Add, &&op_Sub, &&op_Mul, &&op_Div, &&op_Mod,
+        &&op_Less, &&op_LessEqual, &&op_Greater, &&op_GreaterEqual, &&op_Equal, &&op_NotEqual,
+        &&op_Jump, &&op_JumpIfZero, &&op_JumpIfNotZero,
+        &&op_GetFlag, &&op_SetFlag,
+        &&op_Call,
+        &&op_End
+    };
+    static_assert(sizeof(labels) / sizeof(labels[0]) == static_cast<size_t>(ScriptOp::Count), "opcode table out of date");
+#define VM_CASE(name) op_##name:
+#define VM_NEXT() goto *labels[static_cast<int>((++ip)->op)]
+#define VM_JUMP(target) do { executed += static_cast<int>(ip - blockStart) + 1; ip = blockStart = code + (target); goto *labels[static_cast<int>(ip->op)]; } while (0)
+    goto *labels[static_cast<int>(ip->op)];
+#else
+#define VM_CASE(name) case ScriptOp::name:
+#define VM_NEXT() do { ++ip; goto dispatch; } while (0)
+#define VM_JUMP(target) do { executed += static_cast<int>(ip - blockStart) + 1; ip = blockStart = code + (target); goto dispatch; } while (0)
+dispatch:
+    switch (ip->op) {
+#endif
+
+    VM_CASE(LoadConst) r[ip->a] = ip->imm; VM_NEXT();
+    VM_CASE(Move) r[ip->a] = r[ip->b]; VM_NEXT();
+    VM_CASE(Add) r[ip->a] = wrapAdd(r[ip->b], r[ip->c]); VM_NEXT();
+    VM_CASE(Sub) r[ip->a] = wrapSub(r[ip->b], r[ip->c]); VM_NEXT();
+    VM_CASE(Mul) r[ip->a] = wrapMul(r[ip->b], r[ip->c]); VM_NEXT();
+    VM_CASE(Div) r[ip->a] = safeDiv(r[ip->b], r[ip->c]); VM_NEXT();
+    VM_CASE(Mod) r[ip->a] = safeMod(r[ip->b], r[ip->c]); VM_NEXT();
+    VM_CASE(Less) r[ip->a] = r[ip->b] < r[ip->c]; VM_NEXT();
+    VM_CASE(LessEqual) r[ip->a] = r[ip->b] <= r[ip->c]; VM_NEXT();
+    VM_CASE(Greater) r[ip->a] = r[ip->b] > r[ip->c]; VM_NEXT();
+    VM_CASE(GreaterEqual) r[ip->a] = r[ip->b] >= r[ip->c]; VM_NEXT();
+    VM_CASE(Equal) r[ip->a] = r[ip->b] == r[ip->c]; VM_NEXT();
+    VM_CASE(NotEqual) r[ip->a] = r[ip->b] != r[ip->c]; VM_NEXT();
+    VM_CASE(Jump)
+        if (executed > maxInstructions) goto out_of_budget;
+        VM_JUMP(ip->imm);
+    VM_CASE(JumpIfZero)
+        if (executed > maxInstructions) goto out_of_budget;
+        if (r[ip->a] == 0) VM_JUMP(ip->imm);
+        VM_NEXT();
+    VM_CASE(JumpIfNotZero)
+        if (executed > maxInstructions) goto out_of_budget;
+        if (r[ip->a] != 0) VM_JUMP(ip->imm);
+        VM_NEXT();
+    VM_CASE(GetFlag) r[ip->a] = flags[ip->imm]; VM_NEXT();
+    VM_CASE(SetFlag) flags[ip->imm] = r[ip->a]; VM_NEXT();
+    VM_CASE(Call) r[ip->a] = functions[ip->imm](*this, &r[ip->b], ip->c); VM_NEXT();
+    VM_CASE(End) goto done;
+
+#ifndef SCRIPT_VM_COMPUTED_GOTO
+    default: goto done;
+    }
+#endif
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_JUMP
+
+out_of_budget:
+    finished = false;
+done:
+    lastInstructionCount = executed + static_cast<int>(ip - blockStart) + 1;
+    return finished;
+}
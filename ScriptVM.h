@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Compact register-based bytecode for designer-authored trigger and cutscene scripts.
+//
+// Script format, one statement per line (# starts a comment):
+//     param who                  next argument passed to run() is named `who`
+//     let n = flag "visitors"    variables hold 32-bit ints; strings are interned ids
+//     n = n + 1                  + - * / % < <= > >= == !=
+//     setflag "visitors" n
+//     if n < 5 goto done         also `if n goto label` (jumps when non-zero)
+//     spawn 400 300              engine calls registered with registerFunction()
+//     done:
+//     end
+
+enum class ScriptOp : uint8_t {
+    LoadConst, Move,
+    Add, Sub, Mul, Div, Mod,
+    Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual,
+    Jump, JumpIfZero, JumpIfNotZero,
+    GetFlag, SetFlag,
+    Call,
+    End,
+    Count
+};
+
+// 8-byte instruction: registers in a, b, c and an immediate (constant, jump target, function or flag id)
+struct ScriptInstruction {
+    ScriptOp op;
+    uint8_t a, b, c;
+    int32_t imm;
+};
+
+struct ScriptProgram {
+    std::vector<ScriptInstruction> code;
+    int paramCount = 0;
+};
+
+class ScriptVM {
+public:
+    static const int REGISTER_COUNT = 32;
+    static const int VARIABLE_COUNT = 24;  // r0-r23 are named variables, the rest are temporaries
+    static const int MAX_CALL_ARGS = 6;
+
+    // Engine calls receive their arguments in a contiguous register range and return one value
+    using NativeFunction = std::function<int(ScriptVM& vm, const int* args, int argCount)>;
+
+    int registerFunction(const std::string& name, NativeFunction function);
+    int findFunction(const std::string& name) const;
+
+    // Strings are interned once at compile time; scripts only pass their ids around
+    int intern(const std::string& text);
+    const std::string& getString(int id) const { return strings[id]; }
+
+    int getFlag(const std::string& name) { return flags[intern(name)]; }
+    void setFlag(const std::string& name, int value) { flags[intern(name)] = value; }
+
+    // Compiles script text. Returns false and fills error with "line N: ..." on failure.
+    bool compile(const std::string& source, ScriptProgram& program, std::string& error);
+
+    // Runs a program to its end. Arguments fill the param registers in order.
+    // Returns false if the script ran more than maxInstructions (checked on jumps) or the program is empty.
+    bool run(const ScriptProgram& program, const int* args = nullptr, int argCount = 0, int maxInstructions = 10000);
+
+    int getLastInstructionCount() const { return lastInstructionCount; }
+
+private:
+    std::vector<NativeFunction> functions;
+    std::unordered_map<std::string, int> functionIds;
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, int> stringIds;
+    std::vector<int> flags;  // Indexed by interned name id
+    int lastInstructionCount = 0;
+};
@@ -0,0 +1,94 @@
+#include "Sleep.h"
+#include <algorithm>
+
+SleepSystem::SleepSystem(float sleepSpeed, int sleepTicks) : sleepSpeed(sleepSpeed), sleepTicks(sleepTicks) {
+}
+
+int SleepSystem::addBody(int userData) {
+    int body;
+    if (!freeBodies.empty()) {
+        body = freeBodies.back();
+        freeBodies.pop_back();
+    }
+    else {
+        body = static_cast<int>(bodies.size());
+        bodies.emplace_back();
+        islandIdle.push_back(0);
+    }
+    bodies[body] = { userData, 0, static_cast<int>(awakeBodies.size()), body, false, true };
+    awakeBodies.push_back(body);
+    return body;
+}
+
+void SleepSystem::removeBody(int body) {
+    if (!bodies[body].sleeping) removeAwake(body);
+    bodies[body].alive = false;
+    bodies[body].sleeping = false;
+    freeBodies.push_back(body);
+}
+
+void SleepSystem::wake(int body) {
+    Body& woken = bodies[body];
+    woken.idleTicks = 0;
+    if (!woken.sleeping) return;
+    woken.sleeping = false;
+    woken.awakeIndex = static_cast<int>(awakeBodies.size());
+    awakeBodies.push_back(body);
+}
+
+void SleepSystem::reportSpeed(int body, float speed) {
+    Body& reported = bodies[body];
+    reported.idleTicks = speed <= sleepSpeed ? reported.idleTicks + 1 : 0;
+}
+
+void SleepSystem::reportContact(int a, int b) {
+    if (!bodies[a].sleeping && !bodies[b].sleeping) contacts.push_back({ a, b });
+}
+
+const std::vector<int>& SleepSystem::update() {
+    fellAsleep.clear();
+    for (int body : awakeBodies) {
+        bodies[body].parent = body;
+    }
+    for (const std::pair<int, int>& contact : contacts) {
+        // Either body may have been removed since it was reported
+        if (!bodies[contact.first].alive || !bodies[contact.second].alive) continue;
+        int a = findRoot(contact.first), b = findRoot(contact.second);
+        if (a != b) bodies[a].parent = b;
+    }
+    contacts.clear();
+
+    // An island is as idle as its busiest body
+    for (int body : awakeBodies) {
+        islandIdle[findRoot(body)] = sleepTicks;
+    }
+    for (int body : awakeBodies) {
+        int& idle = islandIdle[findRoot(body)];
+        idle = std::min(idle, bodies[body].idleTicks);
+    }
+    for (int body : awakeBodies) {
+        if (islandIdle[findRoot(body)] >= sleepTicks) fellAsleep.push_back(body);
+    }
+    for (int body : fellAsleep) {
+        removeAwake(body);
+        bodies[body].sleeping = true;
+    }
+    return fellAsleep;
+}
+
+int SleepSystem::findRoot(int body) {
+    while (bodies[body].parent != body) {
+        bodies[body].parent = bodies[bodies[body].parent].parent;  // Path halving
+        body = bodies[body].parent;
+    }
+    return body;
+}
+
+void SleepSystem::removeAwake(int body) {
+    int index = bodies[body].awakeIndex;
+    int last = awakeBodies.back();
+    awakeBodies[index] = last;
+    bodies[last].awakeIndex = index;
+    awakeBodies.pop_back();
+    bodies[body].awakeIndex = -1;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+
+// Decides when idle bodies can go to sleep. Awake bodies report their speed every tick
+// they are updated and the awake bodies they touch; touching bodies form an island that
+// only falls asleep once every body in it has been slower than the threshold for
+// sleepTicks ticks, so a pile never sleeps while something still pushes it. Sleeping
+// bodies are left out of every per-tick list here; the game skips them elsewhere too
+// and calls wake() on contact or when a script moves them.
+class SleepSystem {
+public:
+    explicit SleepSystem(float sleepSpeed = 0.0f, int sleepTicks = 60);
+
+    int addBody(int userData);  // Starts awake
+    void removeBody(int body);
+    void setUserData(int body, int userData) { bodies[body].userData = userData; }
+    int getUserData(int body) const { return bodies[body].userData; }
+
+    bool isSleeping(int body) const { return bodies[body].sleeping; }
+    void wake(int body);  // Also restarts its idle count
+
+    void reportSpeed(int body, float speed);
+    void reportContact(int a, int b);  // Contacts with sleeping bodies are ignored, wake them instead
+
+    // Builds this tick's islands and puts the idle ones to sleep; returns the bodies that fell asleep
+    const std::vector<int>& update();
+
+    int getSleepingCount() const { return static_cast<int>(bodies.size() - freeBodies.size() - awakeBodies.size()); }
+    int getAwakeCount() const { return static_cast<int>(awakeBodies.size()); }
+
+private:
+    struct Body {
+        int userData;
+        int idleTicks;
+        int awakeIndex;  // Position in awakeBodies, or -1 while sleeping
+        int parent;      // Union-find link while building islands
+        bool sleeping;
+        bool alive;
+    };
+
+    float sleepSpeed;
+    int sleepTicks;
+    std::vector<Body> bodies;
+    std::vector<int> freeBodies;
+    std::vector<int> awakeBodies;
+    std::vector<std::pair<int, int>> contacts;
+    std::vector<int> islandIdle;  // Per island root, the smallest idle count in the island
+    std::vector<int> fellAsleep;
+
+    int findRoot(int body);
+    void removeAwake(int body);
+};
@@ -0,0 +1,49 @@
+#include "SpatialQuery.h"
+#include <algorithm>
+
+// Runs query(i) for every query, in contiguous runs so neighbouring queries stay on one thread
+template <typename Query>
+static void runBatch(WorkerPool& workers, int count, Query&& query) {
+    if (count == 0) return;
+    const int jobs = std::min(count, workers.getThreadCount() + 1);
+    workers.parallelFor(jobs, [&](int job) {
+        const int first = count * job / jobs, last = count * (job + 1) / jobs;
+        for (int i = first; i < last; ++i) {
+            query(i);
+        }
+    });
+}
+
+void queryRegionBatch(const Broadphase& broadphase, WorkerPool& workers, std::span<const RegionQuery> queries,
+                      std::span<int> results, std::span<int> counts) {
+    const size_t slice = queries.empty() ? 0 : results.size() / queries.size();
+    runBatch(workers, static_cast<int>(queries.size()), [&](int i) {
+        counts[i] = broadphase.queryRegion(queries[i].area, results.subspan(i * slice, slice), queries[i].filter);
+    });
+}
+
+void queryRadiusBatch(const Broadphase& broadphase, WorkerPool& workers, std::span<const CircleQuery> queries,
+                      std::span<int> results, std::span<int> counts) {
+    const size_t slice = queries.empty() ? 0 : results.size() / queries.size();
+    runBatch(workers, static_cast<int>(queries.size()), [&](int i) {
+        const CircleQuery& query = queries[i];
+        counts[i] = broadphase.queryRadius(query.x, query.y, query.radius, results.subspan(i * slice, slice), query.filter);
+    });
+}
+
+void queryNearestBatch(const Broadphase& broadphase, WorkerPool& workers, std::span<const NearestQuery> queries,
+                       std::span<int> results, std::span<int> counts) {
+    const size_t slice = queries.empty() ? 0 : results.size() / queries.size();
+    runBatch(workers, static_cast<int>(queries.size()), [&](int i) {
+        const NearestQuery& query = queries[i];
+        counts[i] = broadphase.queryNearest(query.x, query.y, query.maxDistance, results.subspan(i * slice, slice), query.filter);
+    });
+}
+
+void raycastBatch(const Broadphase& broadphase, WorkerPool& workers, std::span<const RayQuery> queries,
+                  std::span<RaycastHit> hits) {
+    runBatch(workers, static_cast<int>(queries.size()), [&](int i) {
+        const RayQuery& query = queries[i];
+        broadphase.raycast(query.x0, query.y0, query.x1, query.y1, hits[i], query.filter);
+    });
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <SDL.h>
+#include <span>
+#include "Broadphase.h"
+#include "WorkerPool.h"
+
+struct RegionQuery {
+    SDL_Rect area;
+    QueryFilter filter;
+};
+
+struct CircleQuery {
+    float x, y, radius;
+    QueryFilter filter;
+};
+
+struct RayQuery {
+    float x0, y0, x1, y1;
+    QueryFilter filter;
+};
+
+struct NearestQuery {
+    float x, y, maxDistance;
+    QueryFilter filter;
+};
+
+// Batched broadphase queries, split into contiguous runs across the workers. Every query gets
+// an equal slice of results (results.size() / queries.size() slots, query i starting at
+// i * slice) and counts[i] gets what the single query would return, so nothing is allocated
+// and the callers' buffers can be reused frame to frame. Queries close together in the list
+// share cells, so keeping them in spatial order (e.g. sprite order) helps the caches.
+void queryRegionBatch(const Broadphase& broadphase, WorkerPool& workers, std::span<const RegionQuery> queries,
+                      std::span<int> results, std::span<int> counts);
+void queryRadiusBatch(const Broadphase& broadphase, WorkerPool& workers, std::span<const CircleQuery> queries,
+                      std::span<int> results, std::span<int> counts);
+void queryNearestBatch(const Broadphase& broadphase, WorkerPool& workers, std::span<const NearestQuery> queries,
+                       std::span<int> results, std::span<int> counts);
+// First hit of each ray; hits[i].proxy is -1 when ray i hits nothing
+void raycastBatch(const Broadphase& broadphase, WorkerPool& workers, std::span<const RayQuery> queries,
+                  std::span<RaycastHit> hits);
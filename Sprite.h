@@ -0,0 +1,41 @@
+#pragma once
+#include <SDL.h>
+#include "TimerWheel.h"
+
+// Structure to represent a sprite
+struct Sprite {
+    SDL_Rect rect;         // Rectangle representing position and size
+    int speedX, speedY;    // Movement speeds in the x and y directions
+    int moveX, moveY;      // How far the sprite moved this frame, for swept collisions
+    int lifetime;          // Lifetime of the sprite in frames, 0 once it expired
+    TimerHandle lifetimeTimer;  // Fires in the TimerWheel when the lifetime runs out
+    SDL_Texture* texture;  // Texture to render
+    SDL_Rect srcRect;      // Region of the texture to draw (w == 0 draws the whole texture)
+    int region;            // Atlas region shown by srcRect, or -1 if the texture is not an atlas
+    SDL_Color tint;        // Team colour the texture is modulated with (white draws it unchanged)
+    SDL_Texture* flashTexture;  // Palette-swapped copy of the character shown during hit flashes, if any
+    int flashFrames;       // Frames left of the current hit flash
+    int animator;          // Animator in the AnimationSystem, or -1 for a static sprite
+    int proxy;             // Broadphase proxy used for collisions and triggers
+    int lodEntity;         // Entry in the UpdateScheduler, decides how often the sprite moves (-1 while asleep)
+    int body;              // Body in the SleepSystem
+    int viewer;            // Viewer in the FieldOfView, what the sprite can see
+    int light;             // Lantern in the LightMap, or -1 if the sprite carries none
+    SDL_Rect lastDrawnRect;  // Where the sprite was last drawn (used by dirty-rect rendering)
+};
+
+// Whether the sprite is drawn from its flash texture this frame
+inline bool isFlashing(const Sprite& sprite) {
+    return sprite.flashFrames > 0 && sprite.flashTexture;
+}
+
+// Texture to pass to SDL_RenderCopy for a sprite
+inline SDL_Texture* getDrawTexture(const Sprite& sprite) {
+    return isFlashing(sprite) ? sprite.flashTexture : sprite.texture;
+}
+
+// Source rectangle to pass to SDL_RenderCopy for a sprite
+inline const SDL_Rect* getSourceRect(const Sprite& sprite) {
+    if (isFlashing(sprite)) return nullptr;  // Flash textures hold a single image
+    return sprite.srcRect.w > 0 ? &sprite.srcRect : nullptr;
+}
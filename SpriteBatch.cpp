@@ -0,0 +1,89 @@
+#include "SpriteBatch.h"
+
+SpriteBatch::SpriteBatch(WorkerPool& workers, int spritesPerChunk)
+    : workers(workers), spritesPerChunk(spritesPerChunk) {
+}
+
+void SpriteBatch::build(const std::vector<Sprite>& sprites, const std::vector<int>& drawOrder, const Camera& camera,
+                        const SpriteAtlas& atlas, int level) {
+    texture = level == 0 ? atlas.texture : atlas.mipLevels[level - 1].texture;
+    const std::vector<SDL_Rect>& regions = level == 0 ? atlas.regions : atlas.mipLevels[level - 1].regions;
+
+    int textureWidth = 1, textureHeight = 1;
+    SDL_QueryTexture(texture, nullptr, nullptr, &textureWidth, &textureHeight);
+    const float invWidth = 1.0f / textureWidth;
+    const float invHeight = 1.0f / textureHeight;
+
+    // Buffers only ever grow, so steady-state frames allocate nothing
+    const int count = static_cast<int>(drawOrder.size());
+    activeChunks = (count + spritesPerChunk - 1) / spritesPerChunk;
+    if (static_cast<int>(chunks.size()) < activeChunks) chunks.resize(activeChunks);
+    const int maxQuads = count < spritesPerChunk ? count : spritesPerChunk;
+    for (int quad = static_cast<int>(quadIndices.size()) / 6; quad < maxQuads; ++quad) {
+        int base = quad * 4;
+        int pattern[6] = { base, base + 1, base + 2, base + 2, base + 1, base + 3 };
+        quadIndices.insert(quadIndices.end(), pattern, pattern + 6);
+    }
+
+    workers.parallelFor(activeChunks, [&](int chunkIndex) {
+        Chunk& chunk = chunks[chunkIndex];
+        const int begin = chunkIndex * spritesPerChunk;
+        const int end = begin + spritesPerChunk < count ? begin + spritesPerChunk : count;
+        if (chunk.vertices.size() < static_cast<size_t>(end - begin) * 4) {
+            chunk.vertices.resize(static_cast<size_t>(end - begin) * 4);
+        }
+
+        int quads = 0;
+        chunk.runs.clear();
+        for (int i = begin; i < end; ++i) {
+            const Sprite& sprite = sprites[drawOrder[i]];
+            if (!camera.isVisible(sprite.rect)) continue;
+
+            SDL_FRect dest = camera.worldToScreen(sprite.rect);
+            SDL_Texture* quadTexture = texture;
+            float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;  // Flash textures are drawn whole
+            if (isFlashing(sprite)) {
+                quadTexture = sprite.flashTexture;
+            }
+            else {
+                const SDL_Rect& source = regions[sprite.region];
+                u0 = source.x * invWidth;
+                v0 = source.y * invHeight;
+                u1 = (source.x + source.w) * invWidth;
+                v1 = (source.y + source.h) * invHeight;
+            }
+            if (chunk.runs.empty() || chunk.runs.back().texture != quadTexture) {
+                chunk.runs.push_back({ quadTexture, quads, 0 });
+            }
+            chunk.runs.back().quads++;
+
+            SDL_Vertex* v = &chunk.vertices[static_cast<size_t>(quads) * 4];
+            const SDL_Color tint = sprite.tint;  // Team colour, the same multiply a tinted palette would do
+            v[0] = { { dest.x, dest.y }, tint, { u0, v0 } };
+            v[1] = { { dest.x + dest.w, dest.y }, tint, { u1, v0 } };
+            v[2] = { { dest.x, dest.y + dest.h }, tint, { u0, v1 } };
+            v[3] = { { dest.x + dest.w, dest.y + dest.h }, tint, { u1, v1 } };
+            ++quads;
+        }
+        chunk.quads = quads;
+    });
+}
+
+void SpriteBatch::submit(SDL_Renderer* renderer) {
+    for (int i = 0; i < activeChunks; ++i) {
+        const Chunk& chunk = chunks[i];
+        for (const Run& run : chunk.runs) {
+            // The shared index pattern starts at vertex 0, so each run passes its own first vertex
+            SDL_RenderGeometry(renderer, run.texture, &chunk.vertices[static_cast<size_t>(run.firstQuad) * 4], run.quads * 4,
+                               quadIndices.data(), run.quads * 6);
+        }
+    }
+}
+
+int SpriteBatch::getQuadCount() const {
+    int total = 0;
+    for (int i = 0; i < activeChunks; ++i) {
+        total += chunks[i].quads;
+    }
+    return total;
+}
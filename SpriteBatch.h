@@ -0,0 +1,48 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "Atlas.h"
+#include "Camera.h"
+#include "Sprite.h"
+#include "WorkerPool.h"
+
+// Builds vertex data for atlas sprites in parallel and submits it in draw order.
+// The sorted sprite list is cut into contiguous chunks; each worker fills the
+// preallocated vertex buffer of its chunk, then the render thread submits the
+// chunks one after another with SDL_RenderGeometry, as SDL requires. Sprites in a hit
+// flash are drawn from their own flash texture, which splits their chunk into runs.
+class SpriteBatch {
+public:
+    explicit SpriteBatch(WorkerPool& workers, int spritesPerChunk = 2048);
+
+    // Fills vertices for every visible sprite in drawOrder, reading regions from the given atlas level.
+    // All sprites must come from the atlas (Sprite::region >= 0) unless they are flashing.
+    void build(const std::vector<Sprite>& sprites, const std::vector<int>& drawOrder, const Camera& camera,
+               const SpriteAtlas& atlas, int level);
+
+    // Draws the built chunks in order. Must be called on the render thread.
+    void submit(SDL_Renderer* renderer);
+
+    int getQuadCount() const;
+    int getChunkCount() const { return activeChunks; }
+
+private:
+    // Consecutive quads drawn from the same texture
+    struct Run {
+        SDL_Texture* texture;
+        int firstQuad, quads;
+    };
+
+    struct Chunk {
+        std::vector<SDL_Vertex> vertices;  // Reused every frame, 4 per quad
+        std::vector<Run> runs;             // Usually a single atlas run
+        int quads = 0;
+    };
+
+    WorkerPool& workers;
+    int spritesPerChunk;
+    std::vector<Chunk> chunks;
+    std::vector<int> quadIndices;  // 0,1,2, 2,1,3 per quad, shared by all chunks (read-only during build)
+    int activeChunks = 0;
+    SDL_Texture* texture = nullptr;  // Atlas texture of the level being drawn
+};
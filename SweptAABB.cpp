@@ -0,0 +1,63 @@
+#include "SweptAABB.h"
+#include <algorithm>
+#include <limits>
+
+// Entry and exit times of one axis' interval [aMin, aMin + aSize) moving by d against [bMin, bMin + bSize)
+static bool axisTimes(float aMin, float aSize, float d, float bMin, float bSize, float& entry, float& exit) {
+    if (d == 0.0f) {
+        if (aMin + aSize <= bMin || aMin >= bMin + bSize) return false;  // Never overlaps on this axis
+        entry = -std::numeric_limits<float>::infinity();
+        exit = std::numeric_limits<float>::infinity();
+        return true;
+    }
+    float near = d > 0.0f ? bMin - (aMin + aSize) : bMin + bSize - aMin;
+    float far = d > 0.0f ? bMin + bSize - aMin : bMin - (aMin + aSize);
+    entry = near / d;
+    exit = far / d;
+    return true;
+}
+
+bool sweepAABB(const SDL_Rect& a, float dx, float dy, const SDL_Rect& b, SweepHit& hit) {
+    // Already overlapping: separate along the axis that needs the smaller push
+    if (a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y) {
+        int pushLeft = a.x + a.w - b.x, pushRight = b.x + b.w - a.x;
+        int pushUp = a.y + a.h - b.y, pushDown = b.y + b.h - a.y;
+        hit.time = 0.0f;
+        if (std::min(pushLeft, pushRight) < std::min(pushUp, pushDown)) {
+            hit.normalX = pushLeft < pushRight ? -1.0f : 1.0f;
+            hit.normalY = 0.0f;
+        }
+        else {
+            hit.normalX = 0.0f;
+            hit.normalY = pushUp < pushDown ? -1.0f : 1.0f;
+        }
+        return true;
+    }
+
+    float entryX, exitX, entryY, exitY;
+    if (!axisTimes(static_cast<float>(a.x), static_cast<float>(a.w), dx, static_cast<float>(b.x), static_cast<float>(b.w), entryX, exitX) ||
+        !axisTimes(static_cast<float>(a.y), static_cast<float>(a.h), dy, static_cast<float>(b.y), static_cast<float>(b.h), entryY, exitY)) {
+        return false;
+    }
+
+    // Contact starts when both axes overlap and ends when either stops
+    float entry = std::max(entryX, entryY);
+    float exit = std::min(exitX, exitY);
+    if (entry >= exit || entry < 0.0f || entry > 1.0f) return false;
+
+    hit.time = entry;
+    if (entryX > entryY) {
+        hit.normalX = dx > 0.0f ? -1.0f : 1.0f;
+        hit.normalY = 0.0f;
+    }
+    else {
+        hit.normalX = 0.0f;
+        hit.normalY = dy > 0.0f ? -1.0f : 1.0f;
+    }
+    return true;
+}
+
+SDL_Rect sweptBounds(const SDL_Rect& start, int dx, int dy) {
+    return { std::min(start.x, start.x + dx), std::min(start.y, start.y + dy),
+             start.w + (dx < 0 ? -dx : dx), start.h + (dy < 0 ? -dy : dy) };
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <SDL.h>
+
+// Result of a swept box test
+struct SweepHit {
+    float time;              // Fraction of the step at first contact, 0..1
+    float normalX, normalY;  // Contact normal pointing towards the moving box (one axis, the other is 0)
+};
+
+// Continuous (time of impact) test of box a moving by (dx, dy) against a static box b.
+// Boxes that already overlap hit at time 0, with the normal along the shallower axis.
+// Returns false if they don't touch during the step.
+bool sweepAABB(const SDL_Rect& a, float dx, float dy, const SDL_Rect& b, SweepHit& hit);
+
+// Two moving boxes: a moves by (adx, ady), b by (bdx, bdy) over the same step
+inline bool sweepAABB(const SDL_Rect& a, float adx, float ady, const SDL_Rect& b, float bdx, float bdy, SweepHit& hit) {
+    return sweepAABB(a, adx - bdx, ady - bdy, b, hit);
+}
+
+// Box covering a rectangle over a whole move, for broadphase proxies of fast movers
+SDL_Rect sweptBounds(const SDL_Rect& start, int dx, int dy);
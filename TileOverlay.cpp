@@ -0,0 +1,60 @@
+#include "TileOverlay.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+TileOverlay::~TileOverlay() {
+    destroy();
+}
+
+bool TileOverlay::init(SDL_Renderer* targetRenderer, int overlayColumns, int overlayRows, int overlayChunkSize) {
+    renderer = targetRenderer;
+    columns = overlayColumns;
+    rows = overlayRows;
+    chunkSize = overlayChunkSize;
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, columns, rows);
+    if (!texture) {
+        std::cerr << "Failed to create overlay texture: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    pixels.resize(static_cast<size_t>(chunkSize) * chunkSize);
+    return true;
+}
+
+void TileOverlay::destroy() {
+    if (texture) SDL_DestroyTexture(texture);
+    texture = nullptr;
+}
+
+void TileOverlay::update(const std::vector<int>& chunks, const ColourFunction& colour) {
+    uploaded = 0;
+    if (!texture) return;
+    const int chunkColumns = (columns + chunkSize - 1) / chunkSize;
+    for (int chunk : chunks) {
+        SDL_Rect rect = { (chunk % chunkColumns) * chunkSize, (chunk / chunkColumns) * chunkSize, chunkSize, chunkSize };
+        rect.w = std::min(rect.w, columns - rect.x);
+        rect.h = std::min(rect.h, rows - rect.y);
+        for (int y = 0; y < rect.h; ++y) {
+            for (int x = 0; x < rect.w; ++x) {
+                pixels[static_cast<size_t>(y) * rect.w + x] = colour(rect.x + x, rect.y + y);
+            }
+        }
+        SDL_UpdateTexture(texture, &rect, pixels.data(), rect.w * static_cast<int>(sizeof(uint32_t)));
+        uploaded++;
+    }
+}
+
+void TileOverlay::render(const Camera& camera, int tileSize) {
+    if (!texture) return;
+    SDL_FRect dest = camera.worldToScreen({ 0, 0, columns * tileSize, rows * tileSize });
+    SDL_RenderCopyF(renderer, texture, nullptr, &dest);
+}
+
+SDL_Rect TileOverlay::getChunkScreenRect(int chunk, const Camera& camera, int tileSize) const {
+    const int chunkColumns = (columns + chunkSize - 1) / chunkSize;
+    const int span = chunkSize * tileSize;
+    SDL_FRect screen = camera.worldToScreen({ (chunk % chunkColumns) * span, (chunk / chunkColumns) * span, span, span });
+    int left = static_cast<int>(std::floor(screen.x)), top = static_cast<int>(std::floor(screen.y));
+    return { left, top, static_cast<int>(std::ceil(screen.x + screen.w)) - left, static_cast<int>(std::ceil(screen.y + screen.h)) - top };
+}
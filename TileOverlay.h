@@ -0,0 +1,36 @@
+#pragma once
+#include <SDL.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Camera.h"
+
+// Streaming texture with one texel per tile, drawn stretched over the map (fog, light).
+// The map is split into square chunks and only chunks reported as changed are converted
+// and uploaded.
+class TileOverlay {
+public:
+    using ColourFunction = std::function<uint32_t(int x, int y)>;  // 0xAARRGGBB for a tile
+
+    ~TileOverlay();
+
+    bool init(SDL_Renderer* renderer, int columns, int rows, int chunkSize);  // Returns false if the texture can't be created
+    void destroy();
+
+    // Re-converts the given chunks (row-major chunk indices)
+    void update(const std::vector<int>& chunks, const ColourFunction& colour);
+    void render(const Camera& camera, int tileSize);
+
+    // Where a chunk ends up on screen, rounded outwards (for dirty-rect rendering)
+    SDL_Rect getChunkScreenRect(int chunk, const Camera& camera, int tileSize) const;
+
+    int getUploadedLastUpdate() const { return uploaded; }
+
+private:
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* texture = nullptr;
+    int columns = 0, rows = 0;
+    int chunkSize = 0;
+    std::vector<uint32_t> pixels;  // One chunk at a time
+    int uploaded = 0;
+};
@@ -0,0 +1,20 @@
+#include "Tilemap.h"
+
+Tilemap::Tilemap(int width, int height, int tileSize)
+    : width(width), height(height), tileSize(tileSize), tiles(static_cast<size_t>(width) * height, TILE_FLOOR) {
+}
+
+void Tilemap::setTile(int x, int y, uint8_t tile) {
+    if (!inBounds(x, y)) return;
+    uint8_t& current = tiles[static_cast<size_t>(y) * width + x];
+    if (current == tile) return;
+    current = tile;
+    changes.push_back({ x, y });
+}
+
+TilePoint Tilemap::worldToTile(int worldX, int worldY) const {
+    // Floor division so negative coordinates land in the right tile
+    int x = worldX >= 0 ? worldX / tileSize : (worldX - tileSize + 1) / tileSize;
+    int y = worldY >= 0 ? worldY / tileSize : (worldY - tileSize + 1) / tileSize;
+    return { x, y };
+}
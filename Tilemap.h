@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TilePoint {
+    int x, y;
+};
+
+inline bool operator==(const TilePoint& a, const TilePoint& b) { return a.x == b.x && a.y == b.y; }
+inline bool operator!=(const TilePoint& a, const TilePoint& b) { return !(a == b); }
+
+enum TileType : uint8_t {
+    TILE_FLOOR,
+    TILE_WALL
+};
+
+// Grid of tiles for a scene. Edits are recorded so systems built on top of the map
+// (pathfinding, lighting) can update only what changed; clearChanges() once a frame.
+class Tilemap {
+public:
+    Tilemap(int width, int height, int tileSize);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getTileSize() const { return tileSize; }
+
+    bool inBounds(int x, int y) const { return x >= 0 && y >= 0 && x < width && y < height; }
+    uint8_t getTile(int x, int y) const { return tiles[static_cast<size_t>(y) * width + x]; }
+    bool isWalkable(int x, int y) const { return inBounds(x, y) && getTile(x, y) != TILE_WALL; }
+
+    void setTile(int x, int y, uint8_t tile);  // Out-of-bounds edits are ignored
+    const std::vector<uint8_t>& getTiles() const { return tiles; }  // Row by row
+
+    TilePoint worldToTile(int worldX, int worldY) const;
+
+    const std::vector<TilePoint>& getChanges() const { return changes; }
+    void clearChanges() { changes.clear(); }
+
+private:
+    int width, height;
+    int tileSize;
+    std::vector<uint8_t> tiles;
+    std::vector<TilePoint> changes;  // Tiles edited since the last clearChanges()
+};
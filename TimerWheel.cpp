@@ -0,0 +1,114 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel() : heads(LEVELS * SLOTS, -1) {
+}
+
+TimerHandle TimerWheel::schedule(uint32_t delay, int tag, int userData) {
+    int timer = freeList;
+    if (timer >= 0) {
+        freeList = timers[timer].next;
+    }
+    else {
+        timer = static_cast<int>(timers.size());
+        timers.push_back({});
+    }
+    Timer& t = timers[timer];
+    t.expires = now + (delay > 0 ? delay : 1);
+    t.tag = tag;
+    t.userData = userData;
+    link(timer);
+    activeCount++;
+    return { timer, t.generation };
+}
+
+bool TimerWheel::isActive(TimerHandle handle) const {
+    return handle.index >= 0 && handle.index < static_cast<int>(timers.size()) &&
+        timers[handle.index].generation == handle.generation && timers[handle.index].slot >= 0;
+}
+
+uint32_t TimerWheel::getRemaining(TimerHandle handle) const {
+    return isActive(handle) ? static_cast<uint32_t>(timers[handle.index].expires - now) : 0;
+}
+
+bool TimerWheel::cancel(TimerHandle handle) {
+    if (!isActive(handle)) return false;
+    unlink(handle.index);
+    release(handle.index);
+    return true;
+}
+
+bool TimerWheel::reschedule(TimerHandle& handle, uint32_t delay) {
+    if (!isActive(handle)) return false;
+    unlink(handle.index);
+    timers[handle.index].expires = now + (delay > 0 ? delay : 1);
+    link(handle.index);
+    return true;
+}
+
+void TimerWheel::link(int timer) {
+    Timer& t = timers[timer];
+    uint64_t delta = t.expires - now;
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1)))) ++level;
+    t.slot = level * SLOTS + static_cast<int>((t.expires >> (SLOT_BITS * level)) & (SLOTS - 1));
+    t.prev = -1;
+    t.next = heads[t.slot];
+    if (t.next >= 0) timers[t.next].prev = timer;
+    heads[t.slot] = timer;
+}
+
+void TimerWheel::unlink(int timer) {
+    Timer& t = timers[timer];
+    if (t.prev >= 0) timers[t.prev].next = t.next;
+    else heads[t.slot] = t.next;
+    if (t.next >= 0) timers[t.next].prev = t.prev;
+    t.slot = -1;
+}
+
+void TimerWheel::release(int timer) {
+    Timer& t = timers[timer];
+    t.generation++;  // Old handles stop matching
+    t.slot = -1;
+    t.next = freeList;
+    freeList = timer;
+    activeCount--;
+}
+
+void TimerWheel::cascade(int level) {
+    int slot = level * SLOTS + static_cast<int>((now >> (SLOT_BITS * level)) & (SLOTS - 1));
+    int timer = heads[slot];
+    heads[slot] = -1;
+    while (timer >= 0) {
+        int next = timers[timer].next;
+        link(timer);  // Its remaining delay now fits a finer level
+        timer = next;
+    }
+}
+
+const std::vector<TimerExpiry>& TimerWheel::advance() {
+    expired.clear();
+    now++;
+
+    // When a wheel wraps, the next slot of the coarser wheel comes due and spreads out below
+    for (int level = 1; level < LEVELS; ++level) {
+        if ((now & ((1ull << (SLOT_BITS * level)) - 1)) != 0) break;
+        cascade(level);
+    }
+
+    int slot = static_cast<int>(now & (SLOTS - 1));
+    int timer = heads[slot];
+    heads[slot] = -1;
+    while (timer >= 0) {
+        Timer& t = timers[timer];
+        int next = t.next;
+        if (t.expires == now) {
+            expired.push_back({ { timer, t.generation }, t.tag, t.userData });
+            release(timer);
+        }
+        else {
+            link(timer);  // Only past the top wheel's range: still far away
+        }
+        timer = next;
+    }
+    return expired;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Refers to a scheduled timer; stays safe to use after the timer fired or was cancelled
+struct TimerHandle {
+    int index = -1;
+    uint32_t generation = 0;
+};
+
+struct TimerExpiry {
+    TimerHandle handle;
+    int tag;       // What kind of timer this is (lifetime, cooldown, event...), chosen by the caller
+    int userData;
+};
+
+// Hierarchical timing wheel counting in ticks (frames). Four wheels of 256 slots cover
+// 2^32 ticks; a timer sits in the coarsest wheel that fits its delay and drops to finer
+// wheels as its time approaches. Scheduling and cancelling are O(1), and advance() only
+// touches the timers that are due plus the occasional slot that cascades down.
+class TimerWheel {
+public:
+    TimerWheel();
+
+    // Fires after delay ticks (at least one); returns a handle for cancelling
+    TimerHandle schedule(uint32_t delay, int tag, int userData);
+    bool cancel(TimerHandle handle);                     // False if it already fired or was cancelled
+    bool reschedule(TimerHandle& handle, uint32_t delay);  // Same tag and user data, new delay
+
+    bool isActive(TimerHandle handle) const;
+    uint32_t getRemaining(TimerHandle handle) const;  // Ticks left, 0 if not active
+
+    // Moves time forward one tick and returns the timers that fired, in no particular order
+    const std::vector<TimerExpiry>& advance();
+
+    uint64_t getTick() const { return now; }
+    int getActiveCount() const { return activeCount; }
+
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 8;
+    static const int SLOTS = 1 << SLOT_BITS;
+
+    struct Timer {
+        uint64_t expires;
+        int tag, userData;
+        int prev, next;  // Links inside the slot list, or the free list
+        int slot;        // Index into heads, -1 when not scheduled
+        uint32_t generation;
+    };
+
+    std::vector<Timer> timers;
+    std::vector<int> heads;  // LEVELS * SLOTS list heads
+    int freeList = -1;
+    uint64_t now = 0;
+    int activeCount = 0;
+    std::vector<TimerExpiry> expired;
+
+    void link(int timer);    // Puts a timer in the slot for its expiry time
+    void unlink(int timer);
+    void release(int timer);
+    void cascade(int level);  // Moves the current slot of a level down to finer levels
+};
@@ -0,0 +1,83 @@
+#include "Triggers.h"
+#include <algorithm>
+
+TriggerSystem::TriggerSystem(Broadphase& broadphase) : broadphase(broadphase) {
+}
+
+int TriggerSystem::addTrigger(const SDL_Rect& area, int userData, uint32_t layer, uint32_t mask) {
+    triggerCount++;
+    return broadphase.createProxy(area, userData, PROXY_STATIC | PROXY_TRIGGER, layer, mask);
+}
+
+void TriggerSystem::removeTrigger(int trigger) {
+    // Everything inside leaves, and the overlaps go away so the id can be reused
+    auto first = std::lower_bound(overlaps.begin(), overlaps.end(), makeKey(trigger, 0));
+    auto last = first;
+    while (last != overlaps.end() && static_cast<int>(*last >> 32) == trigger) {
+        pendingExits.push_back({ TriggerEventType::Exit, trigger, static_cast<int>(*last & 0xFFFFFFFFu) });
+        ++last;
+    }
+    overlaps.erase(first, last);
+
+    broadphase.destroyProxy(trigger);
+    triggerCount--;
+}
+
+void TriggerSystem::removeBody(int body) {
+    // Proxy ids are reused, so a stale overlap would give the next body a Stay without an Enter
+    auto removed = std::remove_if(overlaps.begin(), overlaps.end(), [&](uint64_t key) {
+        if (static_cast<int>(key & 0xFFFFFFFFu) != body) return false;
+        pendingExits.push_back({ TriggerEventType::Exit, static_cast<int>(key >> 32), body });
+        return true;
+    });
+    overlaps.erase(removed, overlaps.end());
+}
+
+void TriggerSystem::moveTrigger(int trigger, const SDL_Rect& area) {
+    broadphase.moveProxy(trigger, area);
+}
+
+void TriggerSystem::update(const std::vector<ProxyPair>& pairs) {
+    events.swap(pendingExits);
+    pendingExits.clear();
+
+    // Only pairs that involve a trigger matter; a moving trigger can also be the first proxy
+    newOverlaps.clear();
+    for (const ProxyPair& pair : pairs) {
+        if (broadphase.getFlags(pair.b) & PROXY_TRIGGER) {
+            newOverlaps.push_back(makeKey(pair.b, pair.a));
+        }
+        else if (broadphase.getFlags(pair.a) & PROXY_TRIGGER) {
+            newOverlaps.push_back(makeKey(pair.a, pair.b));
+        }
+    }
+    // Sleeping bodies aren't paired with static triggers any more, but they haven't moved either
+    for (uint64_t key : overlaps) {
+        int trigger = static_cast<int>(key >> 32), body = static_cast<int>(key & 0xFFFFFFFFu);
+        if ((broadphase.getFlags(trigger) & PROXY_STATIC) && broadphase.isSleeping(body)) newOverlaps.push_back(key);
+    }
+    std::sort(newOverlaps.begin(), newOverlaps.end());
+    newOverlaps.erase(std::unique(newOverlaps.begin(), newOverlaps.end()), newOverlaps.end());
+
+    // Walk both sorted sets: only in new = Enter, in both = Stay, only in old = Exit
+    size_t o = 0, n = 0;
+    while (o < overlaps.size() || n < newOverlaps.size()) {
+        uint64_t key;
+        TriggerEventType type;
+        if (n >= newOverlaps.size() || (o < overlaps.size() && overlaps[o] < newOverlaps[n])) {
+            key = overlaps[o++];
+            type = TriggerEventType::Exit;
+        }
+        else if (o >= overlaps.size() || newOverlaps[n] < overlaps[o]) {
+            key = newOverlaps[n++];
+            type = TriggerEventType::Enter;
+        }
+        else {
+            key = overlaps[o++];
+            ++n;
+            type = TriggerEventType::Stay;
+        }
+        events.push_back({ type, static_cast<int>(key >> 32), static_cast<int>(key & 0xFFFFFFFFu) });
+    }
+    overlaps.swap(newOverlaps);
+}
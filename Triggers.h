@@ -0,0 +1,52 @@
+#pragma once
+#include <SDL.h>
+#include <cstdint>
+#include <vector>
+#include "Broadphase.h"
+
+enum class TriggerEventType {
+    Enter,  // A body started overlapping the trigger
+    Stay,   // A body is still inside the trigger
+    Exit    // A body left the trigger (or was destroyed)
+};
+
+struct TriggerEvent {
+    TriggerEventType type;
+    int trigger;  // Trigger id returned by addTrigger()
+    int body;     // Broadphase proxy of the body
+};
+
+// Trigger volumes for events and cutscenes. Triggers are static broadphase proxies,
+// so they only show up in pairs when a moving body is near them. Overlaps from the
+// last frame are kept as a sorted set and diffed against this frame's overlaps.
+class TriggerSystem {
+public:
+    explicit TriggerSystem(Broadphase& broadphase);
+
+    // Returns the trigger id; layer and mask pick which bodies it reacts to (see Broadphase)
+    int addTrigger(const SDL_Rect& area, int userData = -1, uint32_t layer = COLLISION_DEFAULT_LAYER,
+                   uint32_t mask = COLLISION_ALL);
+    void removeTrigger(int trigger);                          // Bodies inside get an Exit event
+    void moveTrigger(int trigger, const SDL_Rect& area);
+    void removeBody(int body);  // Call before destroying a body's proxy; triggers it was in get an Exit event
+
+    // Diffs this frame's broadphase pairs against last frame's overlaps and fills the event list
+    void update(const std::vector<ProxyPair>& pairs);
+
+    const std::vector<TriggerEvent>& getEvents() const { return events; }
+    int getUserData(int trigger) const { return broadphase.getUserData(trigger); }
+    int getOverlapCount() const { return static_cast<int>(overlaps.size()); }
+    int getTriggerCount() const { return triggerCount; }
+
+private:
+    Broadphase& broadphase;
+    int triggerCount = 0;
+    std::vector<uint64_t> overlaps;      // (trigger << 32 | body), sorted
+    std::vector<uint64_t> newOverlaps;
+    std::vector<TriggerEvent> events;
+    std::vector<TriggerEvent> pendingExits;  // From removed triggers and bodies, reported on the next update
+
+    static uint64_t makeKey(int trigger, int body) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(trigger)) << 32 | static_cast<uint32_t>(body);
+    }
+};
@@ -0,0 +1,91 @@
+#include "UpdateScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+int UpdateScheduler::addEntity(float x, float y, int userData, int importance) {
+    int entity;
+    if (!freeEntities.empty()) {
+        entity = freeEntities.back();
+        freeEntities.pop_back();
+    }
+    else {
+        entity = static_cast<int>(entities.size());
+        entities.emplace_back();
+    }
+    entities[entity] = { x, y, userData, importance, 0, 0, -1, time, true };
+    insert(entity, 0);  // New entities update on their first frame and get tiered then
+    return entity;
+}
+
+void UpdateScheduler::removeEntity(int entity) {
+    erase(entity);
+    entities[entity].alive = false;
+    freeEntities.push_back(entity);
+}
+
+int UpdateScheduler::getTierCount(int tier) const {
+    int count = 0;
+    for (int phase = 0; phase < (1 << tier); ++phase) {
+        count += static_cast<int>(buckets[(1 << tier) - 1 + phase].size());
+    }
+    return count;
+}
+
+// Visible entities are tier 0; beyond that each half view of distance adds a tier
+int UpdateScheduler::chooseTier(const Entity& entity, const Camera& camera) const {
+    float halfWidth = camera.screenWidth * 0.5f / camera.zoom;
+    float halfHeight = camera.screenHeight * 0.5f / camera.zoom;
+    float outsideX = std::max(std::fabs(entity.x - camera.x) - halfWidth, 0.0f);
+    float outsideY = std::max(std::fabs(entity.y - camera.y) - halfHeight, 0.0f);
+    float distance = std::max(outsideX, outsideY) / std::max(halfWidth, halfHeight);
+
+    int tier = 0;
+    if (distance > 0.0f) tier = distance < 0.5f ? 1 : distance < 1.0f ? 2 : distance < 2.0f ? 3 : 4;
+    return std::clamp(tier - entity.importance, 0, TIER_COUNT - 1);
+}
+
+void UpdateScheduler::insert(int entity, int tier) {
+    int first = (1 << tier) - 1;
+    int phase = 0;
+    for (int p = 1; p < (1 << tier); ++p) {
+        if (buckets[first + p].size() < buckets[first + phase].size()) phase = p;
+    }
+    std::vector<int>& bucket = buckets[first + phase];
+    entities[entity].tier = tier;
+    entities[entity].phase = phase;
+    entities[entity].bucketSlot = static_cast<int>(bucket.size());
+    bucket.push_back(entity);
+}
+
+void UpdateScheduler::erase(int entity) {
+    Entity& removed = entities[entity];
+    std::vector<int>& bucket = buckets[(1 << removed.tier) - 1 + removed.phase];
+    int last = bucket.back();
+    bucket[removed.bucketSlot] = last;
+    entities[last].bucketSlot = removed.bucketSlot;
+    bucket.pop_back();
+}
+
+const std::vector<ScheduledUpdate>& UpdateScheduler::update(float deltaTime, const Camera& camera) {
+    time += deltaTime;
+    due.clear();
+    for (int tier = 0; tier < TIER_COUNT; ++tier) {
+        int phase = static_cast<int>(frame & ((1u << tier) - 1));
+        for (int entity : buckets[(1 << tier) - 1 + phase]) {
+            Entity& e = entities[entity];
+            due.push_back({ entity, e.userData, static_cast<float>(time - e.lastUpdate) });
+            e.lastUpdate = time;
+        }
+    }
+    frame++;
+
+    // Re-tier after collecting, since moving an entity changes the buckets being walked
+    for (const ScheduledUpdate& update : due) {
+        int tier = chooseTier(entities[update.entity], camera);
+        if (tier != entities[update.entity].tier) {
+            erase(update.entity);
+            insert(update.entity, tier);
+        }
+    }
+    return due;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include "Camera.h"
+
+// One entity due for an update this frame
+struct ScheduledUpdate {
+    int entity;      // Handle from addEntity()
+    int userData;
+    float deltaTime; // Time since the entity's last update, including skipped frames
+};
+
+// Level-of-detail update scheduler. Entities on screen update every frame; the further
+// they are from the view, the longer their update period (up to every 16th frame).
+// Entities with the same period are spread over phase buckets so each frame only
+// touches one bucket per period, and each update gets the time that was skipped.
+class UpdateScheduler {
+public:
+    static const int TIER_COUNT = 5;  // Periods 1, 2, 4, 8 and 16 frames
+
+    int addEntity(float x, float y, int userData, int importance = 0);
+    void removeEntity(int entity);
+
+    void setPosition(int entity, float x, float y) { entities[entity].x = x; entities[entity].y = y; }
+    void setUserData(int entity, int userData) { entities[entity].userData = userData; }
+    void setImportance(int entity, int importance) { entities[entity].importance = importance; }  // Each point halves the period
+
+    // Advances one frame and returns the entities due now. Due entities are re-tiered
+    // from their distance to the camera, so an entity's period changes on its own update.
+    const std::vector<ScheduledUpdate>& update(float deltaTime, const Camera& camera);
+
+    int getEntityCount() const { return static_cast<int>(entities.size() - freeEntities.size()); }
+    int getTierCount(int tier) const;
+
+private:
+    struct Entity {
+        float x, y;
+        int userData;
+        int importance;
+        int tier, phase;
+        int bucketSlot;  // Position inside its bucket
+        double lastUpdate;
+        bool alive;
+    };
+
+    std::vector<Entity> entities;
+    std::vector<int> freeEntities;
+    std::vector<std::vector<int>> buckets = std::vector<std::vector<int>>((1 << TIER_COUNT) - 1);  // Tier t phase p at (1 << t) - 1 + p
+    std::vector<ScheduledUpdate> due;
+    unsigned frame = 0;
+    double time = 0.0;
+
+    int chooseTier(const Entity& entity, const Camera& camera) const;
+    void insert(int entity, int tier);  // Into the least loaded phase of the tier
+    void erase(int entity);
+};
@@ -0,0 +1,92 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <memory>
+
+WorkerPool::WorkerPool(int threadCount) {
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+int WorkerPool::defaultThreadCount() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? static_cast<int>(cores) - 1 : 0;
+}
+
+void WorkerPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void WorkerPool::enqueue(std::function<void()> task) {
+    if (threads.empty()) {
+        task();  // No workers, run it right away
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void WorkerPool::parallelFor(int jobCount, const std::function<void(int job)>& job) {
+    if (jobCount <= 0) return;
+    if (jobCount == 1 || threads.empty()) {
+        for (int i = 0; i < jobCount; ++i) job(i);
+        return;
+    }
+
+    // Jobs are claimed from a shared counter by whoever is free, including this thread.
+    // State is shared so helpers that start after everything is done still find it alive.
+    struct Shared {
+        std::atomic<int> next{ 0 };
+        std::atomic<int> done{ 0 };
+        int count = 0;
+        std::function<void(int)> job;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto shared = std::make_shared<Shared>();
+    shared->count = jobCount;
+    shared->job = job;
+
+    auto runJobs = [](Shared& state) {
+        for (int i = state.next++; i < state.count; i = state.next++) {
+            state.job(i);
+            if (++state.done == state.count) {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.finished.notify_all();
+            }
+        }
+    };
+
+    int helpers = std::min(jobCount - 1, static_cast<int>(threads.size()));
+    for (int i = 0; i < helpers; ++i) {
+        enqueue([shared, runJobs] { runJobs(*shared); });
+    }
+    runJobs(*shared);
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->finished.wait(lock, [&] { return shared->done.load() == shared->count; });
+}
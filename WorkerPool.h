@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads shared by engine systems.
+// parallelFor() splits work across the workers and the calling thread and waits for it;
+// enqueue() runs a task in the background.
+class WorkerPool {
+public:
+    explicit WorkerPool(int threadCount);  // 0 runs everything on the calling thread
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Calls job(i) for every i in [0, jobCount) and returns when all calls have finished.
+    // The calling thread takes jobs too, so this never stalls behind background tasks.
+    void parallelFor(int jobCount, const std::function<void(int job)>& job);
+
+    // Runs a task on a worker thread without waiting for it
+    void enqueue(std::function<void()> task);
+
+    int getThreadCount() const { return static_cast<int>(threads.size()); }
+
+    // Threads to use for a pool that leaves one core for the main thread
+    static int defaultThreadCount();
+
+private:
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop();
+};
@@ -9,17 +9,59 @@
 #include <ctime>
 #include <algorithm>
 #include <string>
+#include <fstream>
+#include <sstream>
+#include "Sprite.h"
+#include "DirtyRects.h"
+#include "Atlas.h"
+#include "Animation.h"
+#include "DepthSort.h"
+#include "Palette.h"
+#include "Camera.h"
+#include "WorkerPool.h"
+#include "SpriteBatch.h"
+#include "Broadphase.h"
+#include "Triggers.h"
+#include "EventBus.h"
+#include "Script.h"
+#include "ScriptVM.h"
+#include "Tilemap.h"
+#include "Pathfinding.h"
+#include "FlowField.h"
+#include "UpdateScheduler.h"
+#include "TimerWheel.h"
+#include "Scene.h"
+#include "FieldOfView.h"
+#include "FogOfWar.h"
+#include "TileOverlay.h"
+#include "Lighting.h"
+#include "CollisionMask.h"
+#include "ParticleSystem.h"
+#include "SweptAABB.h"
+#include "Sleep.h"
+#include "SpatialQuery.h"
 
 // Screen dimensions
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
 
-// Structure to represent a sprite
-struct Sprite {
-    SDL_Rect rect;         // Rectangle representing position and size
-    int speedX, speedY;    // Movement speeds in the x and y directions
-    int lifetime;          // Remaining lifetime of the sprite (in frames)
-    SDL_Texture* texture;  // Texture to render
+// Kinds of timers in the frame timing wheel
+enum TimerTag {
+    TIMER_LIFETIME,  // User data is the sprite's broadphase proxy
+    TIMER_DOOR       // Toggles a random tile
+};
+
+// Collision layers of broadphase proxies
+enum CollisionLayer : uint32_t {
+    LAYER_NPC = 1 << 0,      // Solid sprites
+    LAYER_GHOST = 1 << 1,    // Sprites that pass through others but still set off triggers
+    LAYER_TRIGGER = 1 << 2
+};
+
+// Sprite contact found this frame; contacts are resolved earliest first
+struct SpriteContact {
+    SweepHit hit;  // Normal points towards sprite a
+    int a, b;      // Broadphase proxies
 };
 
 // Function declaration for collision checking
@@ -57,7 +99,7 @@ void cleanup(SDL_Window* window, SDL_Renderer* renderer, const std::vector<SDL_T
 }
 
 // Spawns a new sprite with random properties
-Sprite spawnSprite(const std::vector<SDL_Texture*>& textures) {
+Sprite spawnSprite(const SpriteAtlas& atlas) {
     Sprite sprite;
     // Random position within screen bounds, minus sprite size
     sprite.rect = { rand() % (SCREEN_WIDTH - 50), rand() % (SCREEN_HEIGHT - 50), 50, 50 };
@@ -66,11 +108,99 @@ Sprite spawnSprite(const std::vector<SDL_Texture*>& textures) {
     sprite.speedY = (rand() % 5 + 1) * (rand() % 2 ? 1 : -1);
     // Random lifetime between 100 and 400 frames
     sprite.lifetime = rand() % 300 + 100;
-    // Assign a random texture
-    sprite.texture = textures[rand() % textures.size()];
+    // Assign a random image from the atlas
+    sprite.region = rand() % atlas.regions.size();
+    sprite.texture = atlas.texture;
+    sprite.srcRect = atlas.regions[sprite.region];
+    sprite.animator = -1;             // Static image
+    sprite.tint = { 255, 255, 255, 255 };  // No team colour
+    sprite.flashTexture = nullptr;    // Set up by the caller
+    sprite.flashFrames = 0;
+    sprite.proxy = -1;                // Registered with the broadphase by the caller
+    sprite.lodEntity = -1;            // And with the update scheduler
+    sprite.viewer = -1;               // And with the field of view
+    sprite.light = -1;                // No lantern unless the caller adds one
+    // Not drawn yet, so the first dirty-rect pass only marks the new rect
+    sprite.lastDrawnRect = { 0, 0, 0, 0 };
+    sprite.moveX = sprite.moveY = 0;
     return sprite;
 }
 
+// Moves a sprite by its speed over deltaTime and bounces it off the screen edges
+void moveSprite(Sprite& sprite, float deltaTime) {
+    SDL_Rect start = sprite.rect;
+    sprite.rect.x += static_cast<int>(sprite.speedX * deltaTime * 60);
+    sprite.rect.y += static_cast<int>(sprite.speedY * deltaTime * 60);
+
+    // Bounce off screen edges
+    if (sprite.rect.x <= 0 || sprite.rect.x + sprite.rect.w >= SCREEN_WIDTH) {
+        sprite.speedX = -sprite.speedX;
+    }
+    if (sprite.rect.y <= 0 || sprite.rect.y + sprite.rect.h >= SCREEN_HEIGHT) {
+        sprite.speedY = -sprite.speedY;
+    }
+    // Long catch-up steps can overshoot an edge, so keep the sprite inside
+    sprite.rect.x = std::clamp(sprite.rect.x, 0, SCREEN_WIDTH - sprite.rect.w);
+    sprite.rect.y = std::clamp(sprite.rect.y, 0, SCREEN_HEIGHT - sprite.rect.h);
+    sprite.moveX = sprite.rect.x - start.x;
+    sprite.moveY = sprite.rect.y - start.y;
+}
+
+// Rectangle a sprite started this frame's move from
+SDL_Rect getMoveStart(const Sprite& sprite) {
+    return { sprite.rect.x - sprite.moveX, sprite.rect.y - sprite.moveY, sprite.rect.w, sprite.rect.h };
+}
+
+// Fills a tilemap with a walled room split up by random wall segments, like a small dungeon floor
+void generateDungeon(Tilemap& tilemap) {
+    for (int y = 0; y < tilemap.getHeight(); ++y) {
+        for (int x = 0; x < tilemap.getWidth(); ++x) {
+            bool edge = x == 0 || y == 0 || x == tilemap.getWidth() - 1 || y == tilemap.getHeight() - 1;
+            tilemap.setTile(x, y, edge ? TILE_WALL : TILE_FLOOR);
+        }
+    }
+    for (int i = 0; i < tilemap.getWidth() * tilemap.getHeight() / 40; ++i) {
+        int x = rand() % tilemap.getWidth();
+        int y = rand() % tilemap.getHeight();
+        bool horizontal = rand() % 2;
+        for (int j = 0; j < rand() % 6 + 2; ++j) {
+            tilemap.setTile(horizontal ? x + j : x, horizontal ? y : y + j, TILE_WALL);
+        }
+    }
+    tilemap.clearChanges();  // Generation isn't an edit
+}
+
+// Picks a random walkable tile, or (0, 0) if none was found
+TilePoint randomFloorTile(const Tilemap& tilemap) {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        TilePoint tile = { rand() % tilemap.getWidth(), rand() % tilemap.getHeight() };
+        if (tilemap.isWalkable(tile.x, tile.y)) return tile;
+    }
+    return { 0, 0 };
+}
+
+// Reads a whole text file, used for script sources
+bool loadTextFile(const std::string& path, std::string& text) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+// Test script: greets every sprite that walks into the test trigger, half a second later
+ScriptTask greetVisitors(ScriptScheduler& scripts, int& greetings) {
+    for (;;) {
+        co_await scripts.event(EngineEventType::TriggerEnter);
+        co_await scripts.seconds(0.5f);
+        greetings++;
+    }
+}
+
 int main(int argc, char* argv[]) {
     srand(static_cast<unsigned>(time(0)));  // Seed the random number generator
 
@@ -101,24 +231,384 @@ int main(int argc, char* argv[]) {
     // Create renderer
     SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
-    // Load textures
+    // Load character images. They are palettized, so one 8-bit source per character is kept for runtime
+    // palette swaps; the atlas (with downsampled levels for zoomed-out views) holds each character once
+    const char* characterPaths[] = { "assets/char1.png", "assets/char2.png", "assets/char3.png" };
+    const int characterCount = static_cast<int>(std::size(characterPaths));
+    std::vector<SDL_Surface*> characterImages;
+    std::vector<IndexedImage> characterSources(characterCount);  // Empty where the image has too many colours
+    for (int character = 0; character < characterCount; ++character) {
+        const char* path = characterPaths[character];
+        IndexedImage& image = characterSources[character];
+        if (loadIndexedImage(path, image)) {
+            characterImages.push_back(createPaletteSurface(image, image.palette));
+        }
+        else {
+            image = IndexedImage();
+            characterImages.push_back(IMG_Load(path));  // Use the RGBA image as is
+        }
+    }
+    SpriteAtlas characterAtlas;
+    bool atlasBuilt = buildAtlas(renderer, characterImages, 4, 1, characterAtlas);
+    // Collision masks per atlas region at the drawn size, so transparent corners don't collide
+    std::vector<CollisionMask> collisionMasks(characterImages.size());
+    for (size_t i = 0; i < characterImages.size(); ++i) {
+        createCollisionMask(characterImages[i], 50, 50, 128, collisionMasks[i]);
+    }
+    for (SDL_Surface* image : characterImages) {
+        SDL_FreeSurface(image);
+    }
+
+    // Team colours modulate the atlas when drawing, the same multiply a tinted palette would bake in
+    const SDL_Color teamTints[] = { { 255, 255, 255, 255 }, { 255, 140, 140, 255 }, { 140, 170, 255, 255 } };
+
+    // Hit flashes draw a character through a flash palette. Each character gets one streaming texture
+    // (atlas regions are in character order), whose palette is swapped to make the flash strobe.
+    const SDL_Color flashColors[] = { { 255, 255, 255, 255 }, { 255, 220, 120, 255 } };
+    int flashPhase = 0;
+    std::vector<SDL_Texture*> flashTextures(characterCount, nullptr);
+    for (int character = 0; character < characterCount; ++character) {
+        const IndexedImage& image = characterSources[character];
+        if (image.width == 0) continue;  // No indexed source, so no flash
+        flashTextures[character] = createPaletteTexture(renderer, image, flashPalette(image.palette, flashColors[flashPhase]));
+    }
+
+    // Textures to destroy on exit
     std::vector<SDL_Texture*> textures;
-    textures.push_back(loadTexture(renderer, "assets/char1.png"));
-    textures.push_back(loadTexture(renderer, "assets/char2.png"));
-    textures.push_back(loadTexture(renderer, "assets/char3.png"));
+    if (characterAtlas.texture) textures.push_back(characterAtlas.texture);
+    for (const AtlasLevel& level : characterAtlas.mipLevels) {
+        textures.push_back(level.texture);
+    }
+    for (SDL_Texture* texture : flashTextures) {
+        if (texture) textures.push_back(texture);
+    }
 
     // Check for texture loading errors
-    for (size_t i = 0; i < textures.size(); ++i) {
-        if (!textures[i]) {
-            std::cerr << "Error: Texture " << i + 1 << " failed to load!" << std::endl;
-            cleanup(window, renderer, textures);
-            return 1;
-        }
+    if (!atlasBuilt) {
+        std::cerr << "Error: Character textures failed to load!" << std::endl;
+        cleanup(window, renderer, textures);
+        return 1;
     }
 
+    // Screen pixels per atlas texel at zoom 1 (sprites are drawn 50x50), used to pick mip levels
+    float characterScale = 50.0f;
+    for (const SDL_Rect& region : characterAtlas.regions) {
+        characterScale = std::min({ characterScale, 50.0f / region.w, 50.0f / region.h });
+    }
+
+    Camera camera;
+    camera.x = SCREEN_WIDTH / 2.0f;
+    camera.y = SCREEN_HEIGHT / 2.0f;
+    camera.screenWidth = SCREEN_WIDTH;
+    camera.screenHeight = SCREEN_HEIGHT;
+
+    // Dirty-rect rendering redraws only what changed into a persistent back buffer
+    DirtyRectRenderer dirtyRenderer(SCREEN_WIDTH, SCREEN_HEIGHT);
+    bool dirtyRectsSupported = dirtyRenderer.init(renderer);
+    bool useDirtyRects = false;
+    bool drewDirtyRects = false;  // Whether last frame went through the dirty-rect path
+
+    // Sprite-sheet animations play clips made of character atlas regions
+    AnimationSystem animations(characterAtlas);
+    // Some sprites shapeshift through every character
+    std::vector<AnimationFrame> shapeshiftFrames;
+    for (int region = 0; region < static_cast<int>(characterAtlas.regions.size()); ++region) {
+        shapeshiftFrames.push_back({ region, 0.25f });
+    }
+    int shapeshiftClip = shapeshiftFrames.size() > 1 ? animations.addClip("shapeshift", shapeshiftFrames, LoopMode::PingPong) : -1;
+
+    DepthSorter depthSorter;  // Keeps sprites in y order across frames
+
+    // Vertex data for sprites is built on worker threads and submitted in order
+    WorkerPool workers(WorkerPool::defaultThreadCount());
+    SpriteBatch spriteBatch(workers);
+    bool useBatching = true;
+
+    // Dungeon tilemap with hierarchical pathfinding; NPC path requests are solved in batches on the workers
+    Tilemap tilemap(SCREEN_WIDTH / 25, SCREEN_HEIGHT / 25, 25);
+    generateDungeon(tilemap);
+    // Shared crowd goals, like the bar, the door and a table in the tavern
+    const TilePoint crowdGoals[] = { { 3, 3 }, { tilemap.getWidth() / 2, tilemap.getHeight() - 4 }, { tilemap.getWidth() - 4, 5 } };
+    for (const TilePoint& goal : crowdGoals) {
+        tilemap.setTile(goal.x, goal.y, TILE_FLOOR);
+    }
+    tilemap.clearChanges();
+    PathFinder pathFinder(tilemap, workers, 8);
+    int pathRequestsPerFrame = 20;
+    int pathSearchBudget = 32;
+    int pathsFound = 0, pathsFailed = 0;
+
+    // Crowds share one flow field per goal instead of searching per agent
+    FlowFieldCache flowFields(tilemap);
+    bool crowdMode = false;
+
+    // Line of sight per sprite, recomputed only when a sprite changes tile or a wall nearby changes
+    FieldOfView fieldOfView(tilemap, workers);
+    const int viewRadius = 6;
+    int watchers = 0;  // Sprites that saw the trigger tile last frame
+
+    // Fog of war is the union of every sprite's view; only changed chunks of the overlay are re-uploaded
+    FogOfWar fog(tilemap.getWidth(), tilemap.getHeight());
+    TileOverlay fogOverlay;
+    fogOverlay.init(renderer, fog.getWidth(), fog.getHeight(), fog.getChunkSize());
+    std::vector<int> changedChunks;
+    bool showFog = true;
+
+    // Torches on the map and lanterns carried by some sprites; light levels update incrementally
+    LightMap lightMap(tilemap);
+    TileOverlay lightOverlay;
+    lightOverlay.init(renderer, tilemap.getWidth(), tilemap.getHeight(), lightMap.getChunkSize());
+    for (int i = 0; i < 6; ++i) {
+        lightMap.addLight(randomFloorTile(tilemap), 10);
+    }
+    bool showLighting = true;
+
+    // Broadphase finds overlapping sprites and triggers without testing every pair
+    Broadphase broadphase;
+    std::vector<ProxyPair> pairs;
+    std::vector<SpriteContact> contacts;
+    std::vector<uint8_t> bounced;  // Per sprite, whether it already stopped at an impact this frame
+    std::vector<int> bouncedSprites;  // The sprites flagged in bounced
+    std::vector<int> expiredProxies;  // Sprites whose lifetime ran out this frame
+    std::vector<SDL_Rect> particleBounds;  // Screen rectangles of the particle quads, marked dirty around each build
+    TriggerSystem triggers(broadphase);
+    triggers.addTrigger({ SCREEN_WIDTH / 2 - 50, SCREEN_HEIGHT / 2 - 50, 100, 100 }, -1,  // Test trigger in the middle
+                        LAYER_TRIGGER, LAYER_NPC | LAYER_GHOST);
+
+    // Aggro checks: every sprite asks the broadphase for the NPCs near it, all in one batch on the workers
+    const float aggroRadius = 120.0f;
+    const int aggroSlots = 8;  // Neighbours kept per sprite
+    std::vector<CircleQuery> aggroQueries;
+    std::vector<int> aggroResults, aggroCounts;
+    int aggroed = 0;
+    double aggroMicroseconds = 0.0;
+
+    // Systems talk through the event bus; events are handled once per frame in dispatch()
+    EventBus eventBus;
+    int triggerEnters = 0, triggerExits = 0, collisionHits = 0;
+    bool usePixelCollisions = true;
+    int boxHits = 0;  // Rectangle overlaps last frame, before the pixel test
+    eventBus.subscribe(EngineEventType::TriggerEnter, [&](const EngineEvent&) { triggerEnters++; });
+    eventBus.subscribe(EngineEventType::TriggerExit, [&](const EngineEvent&) { triggerExits++; });
+    eventBus.subscribe(EngineEventType::CollisionHit, [&](const EngineEvent&) { collisionHits++; });
+
+    // Coroutine scripts for cutscenes and events; they wake up on timers, frames and bus events
+    ScriptScheduler scripts;
+    scripts.listen(eventBus);
+    int greetings = 0;
+    scripts.start(greetVisitors(scripts, greetings));
+
+    // Effects particles live outside the sprite list: dust where sprites bump, sparks where they die, and a fountain
+    ParticleSystem particles(workers);
+    ParticleEffect dust;
+    dust.colour = { 170, 150, 120, 200 };
+    dust.minSpeed = 10.0f;
+    dust.maxSpeed = 40.0f;
+    dust.minLifetime = 0.3f;
+    dust.maxLifetime = 0.6f;
+    ParticleEffect sparks;
+    sparks.colour = { 255, 190, 80, 255 };
+    sparks.minSpeed = 60.0f;
+    sparks.maxSpeed = 180.0f;
+    sparks.gravity = 300.0f;
+    sparks.size = 2.0f;
+    ParticleEffect fountain = sparks;
+    fountain.colour = { 120, 200, 255, 255 };
+    fountain.minLifetime = 1.0f;
+    fountain.maxLifetime = 2.0f;
+    const int dustEmitter = particles.addEmitter(dust, 0.0f, 0.0f);
+    const int sparkEmitter = particles.addEmitter(sparks, 0.0f, 0.0f);
+    int fountainRate = 1000;  // Particles per second, raise it to stress test
+    const int fountainEmitter = particles.addEmitter(fountain, SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f, static_cast<float>(fountainRate));
+    eventBus.subscribe(EngineEventType::CollisionHit, [&](const EngineEvent& hit) {
+        particles.setEmitterPosition(dustEmitter, hit.x, hit.y);
+        particles.burst(dustEmitter, 12);
+    });
+    eventBus.subscribe(EngineEventType::Death, [&](const EngineEvent& death) {
+        particles.setEmitterPosition(sparkEmitter, death.x + 25.0f, death.y + 25.0f);  // Centre of the 50x50 sprite
+        particles.burst(sparkEmitter, 40);
+    });
+
     std::vector<Sprite> sprites;  // Vector of active sprites
     int spawnTimer = 0;          // Timer to control sprite spawning
 
+    // Lifetimes and scheduled events are registered once and only cost anything when they fire
+    TimerWheel timers;
+    int timersFired = 0;
+    timers.schedule(120, TIMER_DOOR, 0);
+
+    // Sprites far from the view move less often, in buckets spread over frames
+    UpdateScheduler updateScheduler;
+    bool useUpdateLod = true;
+
+    // Sprites that stay still for a second fall asleep and drop out of movement and pair generation
+    SleepSystem sleepSystem(0.0f, 60);
+
+    // Adds a sprite and registers it with the broadphase, the update scheduler and the timers
+    auto addSprite = [&](const Sprite& sprite) -> Sprite& {
+        sprites.push_back(sprite);
+        Sprite& added = sprites.back();
+        int index = static_cast<int>(sprites.size()) - 1;
+        bool ghost = rand() % 5 == 0;  // Some sprites only interact with triggers
+        added.proxy = broadphase.createProxy(added.rect, index, 0, ghost ? LAYER_GHOST : LAYER_NPC,
+                                             ghost ? LAYER_TRIGGER : LAYER_NPC | LAYER_TRIGGER);
+        added.lodEntity = updateScheduler.addEntity(added.rect.x + added.rect.w * 0.5f, added.rect.y + added.rect.h * 0.5f, index);
+        added.lifetimeTimer = timers.schedule(added.lifetime, TIMER_LIFETIME, added.proxy);
+        added.body = sleepSystem.addBody(index);
+        added.animator = shapeshiftClip >= 0 && rand() % 3 == 0 ? animations.createAnimator(shapeshiftClip) : -1;
+        added.tint = teamTints[rand() % std::size(teamTints)];
+        added.flashTexture = flashTextures[added.region];
+        added.light = rand() % 4 == 0 ? lightMap.addLight(tilemap.worldToTile(added.rect.x + added.rect.w / 2, added.rect.y + added.rect.h / 2), 5) : -1;
+        added.viewer = fieldOfView.addViewer(tilemap.worldToTile(added.rect.x + added.rect.w / 2, added.rect.y + added.rect.h / 2), viewRadius);
+        return added;
+    };
+
+    // Unregisters a sprite from every system and swaps the last sprite into its place,
+    // so only the moved sprite's handles need its new index
+    auto removeSprite = [&](int index) {
+        Sprite& sprite = sprites[index];
+        markSpriteRemoved(dirtyRenderer.getTracker(), sprite);  // Its old area must be redrawn
+        if (sprite.animator >= 0) animations.removeAnimator(sprite.animator);
+        triggers.removeBody(sprite.proxy);  // Before the proxy id can be reused
+        broadphase.destroyProxy(sprite.proxy);
+        if (sprite.lodEntity >= 0) updateScheduler.removeEntity(sprite.lodEntity);
+        sleepSystem.removeBody(sprite.body);
+        timers.cancel(sprite.lifetimeTimer);
+        fieldOfView.removeViewer(sprite.viewer);
+        if (sprite.light >= 0) lightMap.removeLight(sprite.light);
+
+        const int last = static_cast<int>(sprites.size()) - 1;
+        depthSorter.onSpriteRemoved(index, last);
+        if (index != last) {
+            sprite = sprites[last];
+            broadphase.setUserData(sprite.proxy, index);
+            if (sprite.lodEntity >= 0) updateScheduler.setUserData(sprite.lodEntity, index);
+            sleepSystem.setUserData(sprite.body, index);
+        }
+        sprites.pop_back();
+    };
+
+    // Sleeping sprites leave the broadphase's active list and the update scheduler until something wakes them
+    auto sleepSprite = [&](Sprite& sprite) {
+        broadphase.setSleeping(sprite.proxy, true);
+        updateScheduler.removeEntity(sprite.lodEntity);
+        sprite.lodEntity = -1;
+    };
+    auto wakeSprite = [&](Sprite& sprite) {
+        if (!sleepSystem.isSleeping(sprite.body)) return;
+        sleepSystem.wake(sprite.body);
+        broadphase.setSleeping(sprite.proxy, false);
+        sprite.lodEntity = updateScheduler.addEntity(sprite.rect.x + sprite.rect.w * 0.5f, sprite.rect.y + sprite.rect.h * 0.5f,
+                                                     static_cast<int>(&sprite - sprites.data()));
+    };
+
+    // Designer scripts run as bytecode; engine calls take the broadphase proxy as the sprite handle
+    ScriptVM scriptVM;
+    auto spriteFromProxy = [&](int proxy) -> Sprite* {
+        if (!broadphase.isAlive(proxy)) return nullptr;  // Sprite already removed
+        int index = broadphase.getUserData(proxy);
+        return index >= 0 && index < static_cast<int>(sprites.size()) ? &sprites[index] : nullptr;
+    };
+
+    // Both sprites of a hit flash for a few frames
+    const int hitFlashFrames = 12;
+    eventBus.subscribe(EngineEventType::CollisionHit, [&](const EngineEvent& hit) {
+        for (int proxy : { hit.a, hit.b }) {
+            if (Sprite* sprite = spriteFromProxy(proxy)) sprite->flashFrames = hitFlashFrames;
+        }
+    });
+    scriptVM.registerFunction("spawn", [&](ScriptVM&, const int* args, int argCount) {
+        if (argCount != 2) return -1;
+        Sprite sprite = spawnSprite(characterAtlas);
+        sprite.rect.x = args[0];
+        sprite.rect.y = args[1];
+        return addSprite(sprite).proxy;
+    });
+    scriptVM.registerFunction("push", [&](ScriptVM&, const int* args, int argCount) {
+        Sprite* sprite = argCount == 3 ? spriteFromProxy(args[0]) : nullptr;
+        if (!sprite) return 0;
+        sprite->speedX = args[1];
+        sprite->speedY = args[2];
+        wakeSprite(*sprite);
+        return 1;
+    });
+    scriptVM.registerFunction("kill", [&](ScriptVM&, const int* args, int argCount) {
+        Sprite* sprite = argCount == 1 ? spriteFromProxy(args[0]) : nullptr;
+        if (!sprite) return 0;
+        timers.reschedule(sprite->lifetimeTimer, 0);  // Removed with the other expired sprites next frame
+        return 1;
+    });
+
+    // Dungeon and tavern scenes; the one not shown stays packed and keeps running in coarse steps on the workers
+    SceneRules sceneRules;
+    sceneRules.width = SCREEN_WIDTH;
+    sceneRules.height = SCREEN_HEIGHT;
+    sceneRules.spawnInterval = 31.0f / 60.0f;  // Same rate as the live spawner
+    sceneRules.regionCount = static_cast<int>(characterAtlas.regions.size());
+    sceneRules.minLifetime = 100;
+    sceneRules.maxLifetime = 399;
+    SceneManager sceneManager(workers, sceneRules);
+
+    // Makes a resumed scene's state the live one: its tiles and its agents as sprites
+    auto goLive = [&](const SceneSnapshot& resumed) {
+        for (int y = 0; y < tilemap.getHeight(); ++y) {
+            for (int x = 0; x < tilemap.getWidth(); ++x) {
+                tilemap.setTile(x, y, resumed.tiles[static_cast<size_t>(y) * tilemap.getWidth() + x]);
+            }
+        }
+        for (const SceneAgent& agent : resumed.agents) {
+            Sprite sprite = spawnSprite(characterAtlas);
+            sprite.rect.x = agent.x;
+            sprite.rect.y = agent.y;
+            sprite.speedX = agent.speedX;
+            sprite.speedY = agent.speedY;
+            sprite.lifetime = agent.lifetime;
+            sprite.region = agent.region;
+            sprite.srcRect = characterAtlas.regions[agent.region];
+            addSprite(sprite);
+        }
+    };
+
+    // The dungeon is live from the start, with its clock starting now
+    SceneSnapshot dungeon;
+    dungeon.tiles = tilemap.getTiles();
+    dungeon.tileColumns = tilemap.getWidth();
+    dungeon.time = SDL_GetTicks() / 1000.0;
+    dungeon.random = static_cast<uint32_t>(rand()) | 1;
+    int activeScene = sceneManager.addScene("Dungeon", std::move(dungeon));
+    goLive(sceneManager.resume(activeScene, SDL_GetTicks() / 1000.0));
+    {
+        Tilemap tavernMap(tilemap.getWidth(), tilemap.getHeight(), tilemap.getTileSize());
+        generateDungeon(tavernMap);
+        for (const TilePoint& goal : crowdGoals) {
+            tavernMap.setTile(goal.x, goal.y, TILE_FLOOR);
+        }
+        SceneSnapshot tavern;
+        tavern.tiles = tavernMap.getTiles();
+        tavern.tileColumns = tavernMap.getWidth();
+        tavern.time = SDL_GetTicks() / 1000.0;
+        tavern.random = static_cast<uint32_t>(rand()) | 1;
+        sceneManager.addScene("Tavern", std::move(tavern));
+    }
+    bool switchScene = false;
+
+    ScriptProgram triggerScript;
+    std::string scriptSource, scriptError;
+    if (loadTextFile("assets/scripts/trigger.ys", scriptSource) &&
+        !scriptVM.compile(scriptSource, triggerScript, scriptError)) {
+        std::cerr << "trigger.ys " << scriptError << std::endl;  // Failed compiles leave the program empty
+    }
+    int scriptRuns = 0, scriptInstructions = 0;
+    double scriptMicroseconds = 0.0;
+    eventBus.subscribe(EngineEventType::TriggerEnter, [&](const EngineEvent& enter) {
+        if (triggerScript.code.empty()) return;
+        Uint64 start = SDL_GetPerformanceCounter();
+        scriptVM.run(triggerScript, &enter.a, 1);
+        scriptMicroseconds = (SDL_GetPerformanceCounter() - start) * 1000000.0 / SDL_GetPerformanceFrequency();
+        scriptInstructions = scriptVM.getLastInstructionCount();
+        scriptRuns++;
+    });
+
     bool isRunning = true;
     SDL_Event event;
 
@@ -141,13 +631,108 @@ int main(int argc, char* argv[]) {
         // ImGui UI
         ImGui::Begin("Debug Info");
         ImGui::Text("Sprite Count: %zu", sprites.size());
+        ImGui::Text("Animators: %d", animations.getAnimatorCount());
+        ImGui::Text("Depth Sort: %d moves%s", depthSorter.getLastMoves(), depthSorter.usedRadixSort() ? " (radix)" : "");
         ImGui::SliderInt("Spawn Timer", &spawnTimer, 0, 60);
+        ImGui::SliderFloat("Zoom", &camera.zoom, 0.1f, 2.0f);
+        ImGui::Text("Atlas Level: %d", selectAtlasLevel(characterAtlas, camera.zoom * characterScale));
+        ImGui::Checkbox("Batched Rendering", &useBatching);
+        if (useBatching && !drewDirtyRects) {
+            ImGui::Text("Batch: %d quads in %d chunks (%d workers)", spriteBatch.getQuadCount(),
+                        spriteBatch.getChunkCount(), workers.getThreadCount());
+        }
+        ImGui::Checkbox("Update LOD", &useUpdateLod);
+        ImGui::Text("LOD Tiers: %d / %d / %d / %d / %d", updateScheduler.getTierCount(0), updateScheduler.getTierCount(1),
+                    updateScheduler.getTierCount(2), updateScheduler.getTierCount(3), updateScheduler.getTierCount(4));
+        ImGui::Text("Timers: %d active, %d fired", timers.getActiveCount(), timersFired);
+        switchScene = ImGui::Button("Switch Scene");
+        for (int scene = 0; scene < sceneManager.getSceneCount(); ++scene) {
+            double now = SDL_GetTicks() / 1000.0;
+            if (sceneManager.isSuspended(scene)) {
+                ImGui::Text("Scene %s: %.1f KB packed (%.1f KB unpacked), %.1f s behind", sceneManager.getName(scene).c_str(),
+                            sceneManager.getMemoryUsage(scene) / 1024.0, sceneManager.getUnpackedBytes(scene) / 1024.0,
+                            sceneManager.getLag(scene, now));
+            }
+            else {
+                size_t liveBytes = sprites.capacity() * sizeof(Sprite) + tilemap.getTiles().capacity();
+                ImGui::Text("Scene %s: live, %.1f KB", sceneManager.getName(scene).c_str(), liveBytes / 1024.0);
+            }
+        }
+        ImGui::Text("Last Resume: %.0f us", sceneManager.getLastResumeMicroseconds());
+        ImGui::Text("Broadphase: %d proxies, %zu pairs", broadphase.getProxyCount(), pairs.size());
+        ImGui::Text("Sleeping: %d of %zu sprites", sleepSystem.getSleepingCount(), sprites.size());
+        ImGui::Text("Aggro: %d of %zu sprites have an NPC within %.0f px (%.0f us)", aggroed, sprites.size(), aggroRadius,
+                    aggroMicroseconds);
+        ImGui::Text("Triggers: %d inside, %d enters, %d exits", triggers.getOverlapCount(), triggerEnters, triggerExits);
+        ImGui::Checkbox("Pixel Collisions", &usePixelCollisions);
+        ImGui::Text("Box Overlaps: %d", boxHits);
+        ImGui::Text("Events: %llu published, %llu dropped, %d hits", static_cast<unsigned long long>(eventBus.getPublished()),
+                    static_cast<unsigned long long>(eventBus.getDropped()), collisionHits);
+        ImGui::Text("Scripts: %d running, %d resumed, %d greetings", scripts.getRunningCount(),
+                    scripts.getResumedLastUpdate(), greetings);
+        ImGui::Text("Script VM: %d runs, last %d instructions in %.1f us, %d visitors", scriptRuns,
+                    scriptInstructions, scriptMicroseconds, scriptVM.getFlag("visitors"));
+        ImGui::SliderInt("Path Requests", &pathRequestsPerFrame, 0, 500);
+        ImGui::SliderInt("Path Budget", &pathSearchBudget, 1, 256);
+        ImGui::Checkbox("Crowd Mode", &crowdMode);
+        ImGui::Text("Flow Fields: %d cached, %d built, %d tiles repaired", flowFields.getFieldCount(),
+                    flowFields.getBuiltLastFrame(), flowFields.getRepairedLastFrame());
+        ImGui::Text("Paths: %d searched, %d cached, %d queued, %d found, %d failed (%d nodes)",
+                    pathFinder.getSearchesLastUpdate(), pathFinder.getCacheHitsLastUpdate(), pathFinder.getPendingCount(),
+                    pathsFound, pathsFailed, pathFinder.getNodeCount());
+        if (ImGui::SliderInt("Particle Rate", &fountainRate, 0, 100000)) {
+            particles.setEmitterRate(fountainEmitter, static_cast<float>(fountainRate));
+        }
+        ImGui::Text("Particles: %d live, %d drawn", particles.getParticleCount(), particles.getQuadCount());
+        if (ImGui::Checkbox("Lighting", &showLighting)) {
+            dirtyRenderer.getTracker().markAllDirty();
+        }
+        ImGui::Text("Lights: %d, %d tiles touched, %d chunks uploaded", lightMap.getLightCount(),
+                    lightMap.getTilesTouchedLastUpdate(), lightOverlay.getUploadedLastUpdate());
+        if (ImGui::Checkbox("Fog of War", &showFog)) {
+            dirtyRenderer.getTracker().markAllDirty();
+        }
+        ImGui::Text("Fog: %d visible, %d explored, %d chunks uploaded (%.1f KB)", fog.countVisible(), fog.countExplored(),
+                    fogOverlay.getUploadedLastUpdate(), fog.getMemoryUsage() / 1024.0);
+        ImGui::Text("Field of View: %d viewers, %d recomputed, %d see the trigger", fieldOfView.getViewerCount(),
+                    fieldOfView.getRecomputedLastUpdate(), watchers);
+        if (dirtyRectsSupported) {
+            ImGui::Checkbox("Dirty Rects (zoom 1 only)", &useDirtyRects);
+            if (drewDirtyRects) {
+                ImGui::Text("Dirty Regions: %d (%d px)", dirtyRenderer.getRegionCount(), dirtyRenderer.getDirtyPixels());
+                ImGui::Text("Sprite Draws: %d", dirtyRenderer.getSpriteDraws());
+            }
+        }
         ImGui::End();
 
+        // Suspend the live scene and bring the other one back, caught up to now
+        double sceneNow = SDL_GetTicks() / 1000.0;
+        if (switchScene) {
+            SceneSnapshot suspended;
+            suspended.tiles = tilemap.getTiles();
+            suspended.tileColumns = tilemap.getWidth();
+            suspended.random = static_cast<uint32_t>(rand()) | 1;
+            for (int i = static_cast<int>(sprites.size()) - 1; i >= 0; --i) {
+                const Sprite& sprite = sprites[i];
+                suspended.agents.push_back({ sprite.rect.x, sprite.rect.y, sprite.speedX, sprite.speedY,
+                                             static_cast<int>(timers.getRemaining(sprite.lifetimeTimer)), sprite.region });
+                removeSprite(i);
+            }
+            sceneManager.suspend(activeScene, std::move(suspended), sceneNow);
+
+            activeScene = (activeScene + 1) % sceneManager.getSceneCount();
+            goLive(sceneManager.resume(activeScene, sceneNow));
+            dirtyRenderer.getTracker().markAllDirty();
+            fog.clear();  // A different place, nothing explored yet
+        }
+        sceneManager.catchUpInBackground(sceneNow);
+
         // Spawn new sprites at regular intervals
         spawnTimer++;
         if (spawnTimer > 30) {
-            sprites.push_back(spawnSprite(textures));
+            const Sprite& spawned = addSprite(spawnSprite(characterAtlas));
+            eventBus.publish(EngineEventType::Spawn, spawned.proxy, -1,
+                             static_cast<float>(spawned.rect.x), static_cast<float>(spawned.rect.y));
             spawnTimer = 0;
         }
 
@@ -156,82 +741,347 @@ int main(int argc, char* argv[]) {
         float deltaTime = (currentTime - lastTime) / 1000.0f;
         lastTime = currentTime;
 
-        for (size_t i = 0; i < sprites.size(); ++i) {
-            sprites[i].rect.x += static_cast<int>(sprites[i].speedX * deltaTime * 60);
-            sprites[i].rect.y += static_cast<int>(sprites[i].speedY * deltaTime * 60);
+        // In crowd mode sprites follow the flow field of their goal; one lookup per goal, not per sprite
+        if (crowdMode) {
+            const FlowField* goalFields[3];
+            for (int goal = 0; goal < 3; ++goal) {
+                goalFields[goal] = &flowFields.getField(crowdGoals[goal]);
+            }
+            for (Sprite& sprite : sprites) {
+                if (sleepSystem.isSleeping(sprite.body)) continue;  // Already seated
+                TilePoint tile = tilemap.worldToTile(sprite.rect.x + sprite.rect.w / 2, sprite.rect.y + sprite.rect.h / 2);
+                int dx, dy;
+                if (tile == crowdGoals[sprite.proxy % 3]) {
+                    sprite.speedX = sprite.speedY = 0;  // Arrived, stay put and eventually sleep
+                }
+                else if (tilemap.inBounds(tile.x, tile.y) && goalFields[sprite.proxy % 3]->getDirection(tile.x, tile.y, dx, dy)) {
+                    sprite.speedX = dx * 3;
+                    sprite.speedY = dy * 3;
+                }
+            }
+        }
 
-            // Bounce off screen edges
-            if (sprites[i].rect.x <= 0 || sprites[i].rect.x + sprites[i].rect.w >= SCREEN_WIDTH) {
-                sprites[i].speedX = -sprites[i].speedX;
+        // Only sprites due this frame move, each by the time since its last update.
+        // Proxies cover the whole move, so sprites that pass each other within one step still pair up
+        for (Sprite& sprite : sprites) {
+            sprite.moveX = sprite.moveY = 0;
+        }
+        const std::vector<ScheduledUpdate>& dueUpdates = updateScheduler.update(deltaTime, camera);
+        if (useUpdateLod) {
+            for (const ScheduledUpdate& update : dueUpdates) {
+                Sprite& sprite = sprites[update.userData];
+                moveSprite(sprite, update.deltaTime);
+                sleepSystem.reportSpeed(sprite.body, static_cast<float>(std::abs(sprite.speedX) + std::abs(sprite.speedY)));
+                updateScheduler.setPosition(sprite.lodEntity, sprite.rect.x + sprite.rect.w * 0.5f, sprite.rect.y + sprite.rect.h * 0.5f);
+                broadphase.moveProxy(sprite.proxy, sweptBounds(getMoveStart(sprite), sprite.moveX, sprite.moveY));
             }
-            if (sprites[i].rect.y <= 0 || sprites[i].rect.y + sprites[i].rect.h >= SCREEN_HEIGHT) {
-                sprites[i].speedY = -sprites[i].speedY;
+        }
+        else {
+            for (Sprite& sprite : sprites) {
+                if (sleepSystem.isSleeping(sprite.body)) continue;
+                moveSprite(sprite, deltaTime);
+                sleepSystem.reportSpeed(sprite.body, static_cast<float>(std::abs(sprite.speedX) + std::abs(sprite.speedY)));
+                broadphase.moveProxy(sprite.proxy, sweptBounds(getMoveStart(sprite), sprite.moveX, sprite.moveY));
             }
+        }
 
-            // Decrease lifetime
-            sprites[i].lifetime--;
+        // Run the timers that came due this frame; expired sprites are removed below
+        expiredProxies.clear();
+        for (const TimerExpiry& expiry : timers.advance()) {
+            timersFired++;
+            if (expiry.tag == TIMER_LIFETIME) {
+                sprites[broadphase.getUserData(expiry.userData)].lifetime = 0;
+                expiredProxies.push_back(expiry.userData);
+            }
+            else if (expiry.tag == TIMER_DOOR) {
+                // Toggle a random inner tile now and then, like a door opening or closing
+                int x = rand() % (tilemap.getWidth() - 2) + 1;
+                int y = rand() % (tilemap.getHeight() - 2) + 1;
+                tilemap.setTile(x, y, tilemap.getTile(x, y) == TILE_WALL ? TILE_FLOOR : TILE_WALL);
+                timers.schedule(120, TIMER_DOOR, 0);
+            }
         }
 
-        // Handle sprite collisions
-        for (size_t i = 0; i < sprites.size(); ++i) {
-            for (size_t j = i + 1; j < sprites.size(); ++j) {
-                if (checkCollision(sprites[i].rect, sprites[j].rect)) {
-                    // Reverse direction of both sprites
-                    sprites[i].speedX = -sprites[i].speedX;
-                    sprites[i].speedY = -sprites[i].speedY;
+        // Handle sprite collisions for the pairs the broadphase found: each pair gets a time of
+        // impact over this frame's moves, so fast sprites can't tunnel through each other
+        broadphase.findPairs(pairs);
+        boxHits = 0;
+        contacts.clear();
+        for (const ProxyPair& pair : pairs) {
+            if ((broadphase.getFlags(pair.a) | broadphase.getFlags(pair.b)) & PROXY_TRIGGER) continue;
+            const Sprite& a = sprites[broadphase.getUserData(pair.a)];
+            const Sprite& b = sprites[broadphase.getUserData(pair.b)];
+            SweepHit hit;
+            if (!sweepAABB(getMoveStart(a), static_cast<float>(a.moveX), static_cast<float>(a.moveY),
+                           getMoveStart(b), static_cast<float>(b.moveX), static_cast<float>(b.moveY), hit)) {
+                continue;
+            }
+            boxHits++;
+            // Sprites that end up overlapping must touch with opaque pixels; ones that
+            // passed through each other within the step always collide
+            if (usePixelCollisions && a.region >= 0 && b.region >= 0 && checkCollision(a.rect, b.rect) &&
+                !masksOverlap(collisionMasks[a.region], a.rect.x, a.rect.y, collisionMasks[b.region], b.rect.x, b.rect.y)) {
+                continue;  // Only transparent pixels overlap
+            }
+            contacts.push_back({ hit, pair.a, pair.b });
+        }
 
-                    sprites[j].speedX = -sprites[j].speedX;
-                    sprites[j].speedY = -sprites[j].speedY;
+        // Touching a sleeper wakes it; touching awake sprites join one island, which only sleeps as a whole
+        for (const SpriteContact& contact : contacts) {
+            Sprite& a = sprites[broadphase.getUserData(contact.a)];
+            Sprite& b = sprites[broadphase.getUserData(contact.b)];
+            wakeSprite(a);
+            wakeSprite(b);
+            sleepSystem.reportContact(a.body, b.body);
+        }
 
-                    // Slightly separate the sprites to prevent overlapping
-                    if (sprites[i].rect.x < sprites[j].rect.x) {
-                        sprites[i].rect.x -= 1;
-                        sprites[j].rect.x += 1;
-                    }
-                    else {
-                        sprites[i].rect.x += 1;
-                        sprites[j].rect.x -= 1;
-                    }
+        // Earliest impacts first. A sprite stops where it first touches something and bounces; a later
+        // contact with a sprite that already stopped is swept again against where it stopped, and goes
+        // back into the queue at its new time, so the other sprite can't finish its move through it
+        const auto later = [](const SpriteContact& x, const SpriteContact& y) { return x.hit.time > y.hit.time; };
+        std::make_heap(contacts.begin(), contacts.end(), later);
+        bounced.assign(sprites.size(), 0);
+        bouncedSprites.clear();
+        while (!contacts.empty()) {
+            std::pop_heap(contacts.begin(), contacts.end(), later);
+            const SpriteContact contact = contacts.back();
+            contacts.pop_back();
+            size_t i = broadphase.getUserData(contact.a);
+            size_t j = broadphase.getUserData(contact.b);
+            if (bounced[i] && bounced[j]) continue;  // Both already stopped this frame
+            SweepHit hit = contact.hit;
+            if (bounced[i] || bounced[j]) {
+                size_t mover = bounced[i] ? j : i;
+                const Sprite& moving = sprites[mover];
+                const Sprite& stopped = sprites[bounced[i] ? i : j];
+                if (!sweepAABB(getMoveStart(moving), static_cast<float>(moving.moveX), static_cast<float>(moving.moveY),
+                               stopped.rect, hit)) {
+                    continue;  // The stopped sprite is out of the way now
+                }
+                if (mover == j) {
+                    hit.normalX = -hit.normalX;  // Keep the normal pointing towards sprite a
+                    hit.normalY = -hit.normalY;
+                }
+                if (hit.time > contact.hit.time) {
+                    contacts.push_back({ hit, contact.a, contact.b });  // Something else may come first
+                    std::push_heap(contacts.begin(), contacts.end(), later);
+                    continue;
+                }
+            }
 
-                    if (sprites[i].rect.y < sprites[j].rect.y) {
-                        sprites[i].rect.y -= 1;
-                        sprites[j].rect.y += 1;
-                    }
-                    else {
-                        sprites[i].rect.y += 1;
-                        sprites[j].rect.y -= 1;
-                    }
+            // Move the sprites that were still moving back to where they touched, and bounce them off
+            for (size_t k : { i, j }) {
+                if (bounced[k]) continue;
+                Sprite& sprite = sprites[k];
+                int travelledX = static_cast<int>(sprite.moveX * hit.time);
+                int travelledY = static_cast<int>(sprite.moveY * hit.time);
+                sprite.rect.x -= sprite.moveX - travelledX;
+                sprite.rect.y -= sprite.moveY - travelledY;
+                sprite.moveX = travelledX;  // Later sweeps against this sprite start from the same place
+                sprite.moveY = travelledY;
+                if (hit.normalX != 0.0f) {
+                    sprite.speedX = -sprite.speedX;
+                }
+                else {
+                    sprite.speedY = -sprite.speedY;
                 }
             }
+            for (size_t k : { i, j }) {
+                if (!bounced[k]) bouncedSprites.push_back(static_cast<int>(k));
+                bounced[k] = 1;
+            }
+
+            // The hit point is halfway between the two centres
+            eventBus.publish(EngineEventType::CollisionHit, contact.a, contact.b,
+                             (sprites[i].rect.x + sprites[j].rect.x) * 0.5f + sprites[i].rect.w * 0.5f,
+                             (sprites[i].rect.y + sprites[j].rect.y) * 0.5f + sprites[i].rect.h * 0.5f);
+
+            // Sprites that started out overlapping are pushed apart a little each frame
+            if (hit.time == 0.0f) {
+                sprites[i].rect.x += static_cast<int>(hit.normalX);
+                sprites[i].rect.y += static_cast<int>(hit.normalY);
+                sprites[j].rect.x -= static_cast<int>(hit.normalX);
+                sprites[j].rect.y -= static_cast<int>(hit.normalY);
+            }
         }
 
-        // Remove expired sprites
-        for (auto it = sprites.begin(); it != sprites.end();) {
-            if (it->lifetime <= 0) {
-                it = sprites.erase(it);  // Remove sprite and update iterator
+        // Stopped sprites were rolled back, so their proxies and LOD positions shrink to the move they kept
+        for (int index : bouncedSprites) {
+            const Sprite& sprite = sprites[index];
+            broadphase.moveProxy(sprite.proxy, sweptBounds(getMoveStart(sprite), sprite.moveX, sprite.moveY));
+            if (sprite.lodEntity >= 0) {
+                updateScheduler.setPosition(sprite.lodEntity, sprite.rect.x + sprite.rect.w * 0.5f, sprite.rect.y + sprite.rect.h * 0.5f);
             }
-            else {
-                ++it;  // Move to the next sprite
+        }
+
+        // Islands that stayed idle long enough go to sleep, after contacts had their say
+        for (int body : sleepSystem.update()) {
+            sleepSprite(sprites[sleepSystem.getUserData(body)]);
+        }
+
+        // Trigger events only come from overlaps that changed or persist
+        triggers.update(pairs);
+        for (const TriggerEvent& triggerEvent : triggers.getEvents()) {
+            static const EngineEventType busTypes[] = {
+                EngineEventType::TriggerEnter, EngineEventType::TriggerStay, EngineEventType::TriggerExit
+            };
+            eventBus.publish(busTypes[static_cast<int>(triggerEvent.type)], triggerEvent.body, triggerEvent.trigger);
+        }
+
+        // Remove expired sprites; removal keeps every proxy -> sprite index valid for the handlers
+        for (int proxy : expiredProxies) {
+            const Sprite& sprite = sprites[broadphase.getUserData(proxy)];
+            eventBus.publish(EngineEventType::Death, proxy, -1,
+                             static_cast<float>(sprite.rect.x), static_cast<float>(sprite.rect.y));
+            removeSprite(broadphase.getUserData(proxy));
+        }
+
+        // Deliver this frame's events now that the simulation step is done
+        eventBus.dispatch();
+        scripts.update(deltaTime);  // Scripts woken by those events run right after
+
+        // Random NPC-style path queries; whatever is over the budget waits for the next frame
+        for (int i = 0; i < pathRequestsPerFrame; ++i) {
+            pathFinder.requestPath(randomFloorTile(tilemap), randomFloorTile(tilemap), i);
+        }
+        pathFinder.update(pathSearchBudget);
+        for (const PathResult& result : pathFinder.getResults()) {
+            (result.found ? pathsFound : pathsFailed)++;
+        }
+        flowFields.update();
+
+        // Sight follows the sprites' tiles; count who can see the tile under the test trigger
+        for (const Sprite& sprite : sprites) {
+            TilePoint tile = tilemap.worldToTile(sprite.rect.x + sprite.rect.w / 2, sprite.rect.y + sprite.rect.h / 2);
+            fieldOfView.setViewerPosition(sprite.viewer, tile);
+            if (sprite.light >= 0) lightMap.setLightPosition(sprite.light, tile);  // Lanterns move with their sprite
+        }
+        fieldOfView.update();
+        TilePoint triggerTile = tilemap.worldToTile(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+        watchers = 0;
+        for (const Sprite& sprite : sprites) {
+            watchers += fieldOfView.canSee(sprite.viewer, triggerTile.x, triggerTile.y);
+        }
+
+        // Each sprite looks for NPCs around its centre, leaving itself out
+        aggroQueries.clear();
+        for (const Sprite& sprite : sprites) {
+            aggroQueries.push_back({ sprite.rect.x + sprite.rect.w * 0.5f, sprite.rect.y + sprite.rect.h * 0.5f, aggroRadius,
+                                     { LAYER_NPC, sprite.proxy } });
+        }
+        aggroResults.resize(aggroQueries.size() * aggroSlots);
+        aggroCounts.resize(aggroQueries.size());
+        Uint64 aggroStart = SDL_GetPerformanceCounter();
+        queryRadiusBatch(broadphase, workers, aggroQueries, aggroResults, aggroCounts);
+        aggroMicroseconds = (SDL_GetPerformanceCounter() - aggroStart) * 1000000.0 / SDL_GetPerformanceFrequency();
+        aggroed = static_cast<int>(std::count_if(aggroCounts.begin(), aggroCounts.end(), [](int count) { return count > 0; }));
+
+        // Fog and light overlays only re-upload the chunks that changed
+        fog.beginFrame();
+        for (const Sprite& sprite : sprites) {
+            fog.reveal(fieldOfView.getVisibility(sprite.viewer));
+        }
+        fog.endFrame();
+        fog.takeDirtyChunks(changedChunks);
+        fogOverlay.update(changedChunks, [&](int x, int y) { return fog.getColour(x, y); });
+        for (int chunk : changedChunks) {
+            if (showFog) dirtyRenderer.getTracker().markDirty(fogOverlay.getChunkScreenRect(chunk, camera, tilemap.getTileSize()));
+        }
+        lightMap.update();
+        lightMap.takeDirtyChunks(changedChunks);
+        lightOverlay.update(changedChunks, [&](int x, int y) { return lightMap.getColour(x, y); });
+        for (int chunk : changedChunks) {
+            if (showLighting) dirtyRenderer.getTracker().markDirty(lightOverlay.getChunkScreenRect(chunk, camera, tilemap.getTileSize()));
+        }
+        tilemap.clearChanges();  // Every system has seen this frame's edits
+
+        particles.update(deltaTime);
+
+        // Hit flashes count down, and strobe by swapping the flash textures' palette
+        bool anyFlashing = false;
+        for (auto& sprite : sprites) {
+            if (sprite.flashFrames == 0) continue;
+            sprite.flashFrames--;
+            anyFlashing = true;
+            dirtyRenderer.getTracker().markDirty(sprite.rect);  // Flash colour changed, or the flash ended
+        }
+        int phase = static_cast<int>(SDL_GetTicks() / 100 % std::size(flashColors));
+        if (anyFlashing && phase != flashPhase) {
+            flashPhase = phase;
+            for (int character = 0; character < characterCount; ++character) {
+                if (!flashTextures[character]) continue;
+                const IndexedImage& image = characterSources[character];
+                applyPalette(flashTextures[character], image, flashPalette(image.palette, flashColors[flashPhase]));
             }
         }
 
-        // Remove expired sprites
-        for (auto it = sprites.begin(); it != sprites.end();) {
-            if (it->lifetime <= 0) {
-                it = sprites.erase(it);  // Remove sprite and update iterator
+        // Advance all animations in one pass, then pick up the frames that changed
+        animations.update(deltaTime);
+        for (auto& sprite : sprites) {
+            if (sprite.animator < 0) continue;
+            const SDL_Rect& frame = animations.getSourceRect(sprite.animator);
+            if (!SDL_RectEquals(&frame, &sprite.srcRect)) {
+                sprite.srcRect = frame;
+                sprite.region = animations.getRegion(sprite.animator);
+                sprite.flashTexture = flashTextures[sprite.region];  // Flashes show the new character
+                dirtyRenderer.getTracker().markDirty(sprite.rect);  // New frame, same place
             }
-            else {
-                ++it;  // Move to the next sprite
+        }
+
+        // Render the scene, back to front
+        const std::vector<int>& drawOrder = depthSorter.sort(sprites);
+        // Drawn over the sprites, once in a full redraw or once per region in a dirty-rect pass
+        auto drawOverlays = [&]() {
+            particles.submit(renderer);
+            if (showLighting) lightOverlay.render(camera, tilemap.getTileSize());
+            if (showFog) fogOverlay.render(camera, tilemap.getTileSize());
+        };
+        bool drawDirtyRects = useDirtyRects && camera.zoom == 1.0f;
+        // Particles move every frame, so a dirty-rect pass redraws both where they were and where they are now
+        auto markParticlesDirty = [&]() {
+            particles.getQuadBounds(particleBounds);
+            for (const SDL_Rect& bounds : particleBounds) {
+                dirtyRenderer.getTracker().markDirty(bounds);
             }
+        };
+        if (drawDirtyRects) markParticlesDirty();
+        particles.build(camera);
+        if (drawDirtyRects) markParticlesDirty();
+        if (drawDirtyRects) {
+            if (!drewDirtyRects) {
+                dirtyRenderer.getTracker().markAllDirty();  // Back buffer is stale after full redraws
+            }
+            dirtyRenderer.render(sprites, drawOrder, drawOverlays);  // Only redraw regions that changed
         }
+        else {
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);  // Clear screen with black
+            SDL_RenderClear(renderer);
 
-        // Render the scene
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);  // Clear screen with black
-        SDL_RenderClear(renderer);
+            // One mip level for the whole batch, picked from how large atlas texels appear on screen
+            int atlasLevel = selectAtlasLevel(characterAtlas, camera.zoom * characterScale);
+            if (useBatching) {
+                spriteBatch.build(sprites, drawOrder, camera, characterAtlas, atlasLevel);
+                spriteBatch.submit(renderer);
+            }
+            else {
+                for (int index : drawOrder) {
+                    const Sprite& sprite = sprites[index];
+                    if (!camera.isVisible(sprite.rect)) continue;
 
-        for (const auto& sprite : sprites) {
-            SDL_RenderCopy(renderer, sprite.texture, nullptr, &sprite.rect);  // Draw sprite
+                    SDL_FRect dest = camera.worldToScreen(sprite.rect);
+                    const SDL_Rect* source = getSourceRect(sprite);
+                    SDL_Texture* texture = getDrawTexture(sprite);
+                    if (sprite.region >= 0 && !isFlashing(sprite)) {
+                        texture = getAtlasRegion(characterAtlas, atlasLevel, sprite.region, source);
+                    }
+                    SDL_SetTextureColorMod(texture, sprite.tint.r, sprite.tint.g, sprite.tint.b);  // Team colour
+                    SDL_RenderCopyF(renderer, texture, source, &dest);  // Draw sprite
+                    SDL_SetTextureColorMod(texture, 255, 255, 255);
+                }
+            }
+            drawOverlays();
         }
+        drewDirtyRects = drawDirtyRects;
 
         // Render ImGui
         ImGui::Render();
@@ -246,6 +1096,9 @@ int main(int argc, char* argv[]) {
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
+    dirtyRenderer.destroy();
+    fogOverlay.destroy();
+    lightOverlay.destroy();
     cleanup(window, renderer, textures);
     return 0;
 }